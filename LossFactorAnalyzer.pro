@@ -10,24 +10,41 @@ CONFIG += c++17
 
 SOURCES += \
     aboutdialog.cpp \
+    analysisworker.cpp \
+    chartdecimator.cpp \
+    diagnosticsdialog.cpp \
+    exportworker.cpp \
     ledindicator.cpp \
     livechartwidget.cpp \
+    logging.cpp \
     main.cpp \
     mainwindow.cpp \
+    metrics.cpp \
     modbusconfigdialog.cpp \
-    modbusreader.cpp
+    modbusreader.cpp \
+    modbusscheduler.cpp \
+    sweeprecorder.cpp
 
 HEADERS += \
     aboutdialog.h \
+    analysisworker.h \
+    chartdecimator.h \
+    diagnosticsdialog.h \
+    exportworker.h \
     ledindicator.h \
     livechartwidget.h \
+    logging.h \
     mainwindow.h \
+    metrics.h \
     modbusconfigdialog.h \
     modbusreader.h \
-    skewed_lorentzian_fit.hpp
+    modbusscheduler.h \
+    spscringbuffer.h \
+    sweeprecorder.h
 
 FORMS += \
     aboutdialog.ui \
+    diagnosticsdialog.ui \
     mainwindow.ui \
     modbusconfigdialog.ui
 
@@ -41,6 +58,9 @@ RESOURCES += \
 
 RC_FILE = app.rc
 
+# Analysis and recording code, shared with the batch analyzer
+include(./analysis.pri)
+
 
 # QXlsx code for Application Qt project
 QXLSX_PARENTPATH=./QXlsx/         # current QXlsx path is . (. means curret directory)
@@ -0,0 +1,13 @@
+# Command-line batch analyzer for recorded sweeps, see batchanalyzer.cpp
+QT       += core concurrent
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = LossFactorBatch
+
+SOURCES += \
+    batchanalyzer.cpp
+
+include(./analysis.pri)
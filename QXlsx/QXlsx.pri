@@ -4,9 +4,18 @@
 
 QT += core
 QT += gui-private
+QT += concurrent
+
+# zlib for the zip writer: Qt's bundled copy if Qt was built with one,
+# otherwise the system library
+qtHaveModule(zlib-private) {
+    QT += zlib-private
+} else {
+    LIBS += -lz
+}
 
 # TODO: Define your C++ version. c++14, c++17, etc.
-CONFIG += c++11
+CONFIG += c++17
 
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which has been marked as deprecated (the exact warnings
@@ -10,6 +10,8 @@
 #include <QString>
 #include <QStringList>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE_XLSX
 
 class ContentTypes : public AbstractOOXmlFile
@@ -40,6 +42,8 @@ public:
 
     void clearOverrides();
 
+    std::shared_ptr<ContentTypes> clone() const;
+
     void saveToXmlFile(QIODevice *device) const override;
     bool loadFromXmlFile(QIODevice *device) override;
 
@@ -9,9 +9,13 @@
 
 #include <QIODevice>
 #include <QImage>
+#include <QMap>
 #include <QObject>
+#include <QString>
 #include <QVariant>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE_XLSX
 
 class Workbook;
@@ -23,6 +27,30 @@ class Chart;
 class CellReference;
 class DocumentPrivate;
 
+/*
+  How the parts of the package are compressed on save. Levels are zlib
+  levels: 0 stores, 1 (fastest) to 9 (smallest), -1 zlib's default.
+  Entries whose file suffix is in suffixLevels use that level instead of
+  the default one, e.g. 0 for media that is compressed already.
+ */
+class QXLSX_EXPORT CompressionPolicy
+{
+public:
+    enum Preset {
+        Balanced, // zlib's default level, images stored
+        Fast,     // level 1, images stored
+        Small,    // level 9 for everything
+        StoreOnly // nothing compressed
+    };
+
+    CompressionPolicy(Preset preset = Balanced);
+
+    int levelFor(const QString &entryPath) const;
+
+    int level = -1;
+    QMap<QString, int> suffixLevels;
+};
+
 class QXLSX_EXPORT Document : public QObject
 {
     Q_OBJECT
@@ -34,6 +62,8 @@ public:
     Document(QIODevice *device, QObject *parent = nullptr);
     ~Document();
 
+    Document *clone(QObject *parent = nullptr) const;
+
     bool write(const CellReference &cell, const QVariant &value, const Format &format = Format());
     bool write(int row, int col, const QVariant &value, const Format &format = Format());
 
@@ -41,6 +71,11 @@ public:
     QVariant read(int row, int col) const;
 
     int insertImage(int row, int col, const QImage &image);
+    int insertImage(int row,
+                    int col,
+                    const QByteArray &data,
+                    const QSize &size     = QSize(),
+                    const QString &suffix = QStringLiteral("png"));
     bool getImage(int imageIndex, QImage &img);
     bool getImage(int row, int col, QImage &img);
     uint getImageCount();
@@ -116,6 +151,11 @@ public:
     bool save() const;
     bool saveAs(const QString &xlsXname) const;
     bool saveAs(QIODevice *device) const;
+    bool saveAs(const QString &xlsXname, const CompressionPolicy &policy) const;
+    bool saveAs(QIODevice *device, const CompressionPolicy &policy) const;
+    bool saveAs(QIODevice *device,
+                const CompressionPolicy &policy,
+                const std::function<bool(int, int)> &progress) const;
 
     bool saveAsCsv(const QString mainCSVFileName) const;
 
@@ -20,7 +20,9 @@ public:
     void init();
 
     bool loadPackage(QIODevice *device);
-    bool savePackage(QIODevice *device) const;
+    bool savePackage(QIODevice *device,
+                     const CompressionPolicy &policy,
+                     const std::function<bool(int, int)> &progress = {}) const;
 
     bool saveCsv(const QString mainCSVFileName) const;
 
@@ -4,11 +4,14 @@
 #define QXLSX_DRAWING_H
 
 #include "xlsxabstractooxmlfile.h"
+#include "xlsxmediafile_p.h"
 #include "xlsxrelationships_p.h"
 
 #include <QList>
 #include <QString>
 
+#include <memory>
+
 class QIODevice;
 class QXmlStreamWriter;
 
@@ -27,6 +30,9 @@ public:
     void saveToXmlFile(QIODevice *device) const override;
     bool loadFromXmlFile(QIODevice *device) override;
 
+    // Copy for the sheet of a cloned workbook
+    std::shared_ptr<Drawing> clone(AbstractSheet *sheet, const MediaFileMap &media) const;
+
     AbstractSheet *sheet;
     Workbook *workbook;
     QList<DrawingAnchor *> anchors;
@@ -4,6 +4,7 @@
 #define QXLSX_XLSXDRAWINGANCHOR_P_H
 
 #include "xlsxglobal.h"
+#include "xlsxmediafile_p.h"
 
 #include <memory>
 
@@ -46,6 +47,8 @@ public:
     virtual ~DrawingAnchor();
 
     void setObjectPicture(const QImage &img);
+    // Already encoded image, stored as is; suffix names its format ("png", "jpeg")
+    void setObjectPicture(const QByteArray &data, const QString &suffix);
     bool getObjectPicture(QImage &img);
 
     void setObjectGraphicFrame(std::shared_ptr<QXlsx::Chart> chart);
@@ -53,10 +56,15 @@ public:
     virtual bool loadFromXml(QXmlStreamReader &reader)     = 0;
     virtual void saveToXml(QXmlStreamWriter &writer) const = 0;
 
+    // Copy of this anchor added to drawing, showing the copy of its picture
+    virtual DrawingAnchor *clone(Drawing *drawing, const MediaFileMap &media) const = 0;
+
     virtual int row() const;
     virtual int col() const;
 
 protected:
+    void attachClone(Drawing *drawing, const MediaFileMap &media);
+
     QPoint loadXmlPos(QXmlStreamReader &reader);
     QSize loadXmlExt(QXmlStreamReader &reader);
     XlsxMarker loadXmlMarker(QXmlStreamReader &reader, const QString &node);
@@ -125,6 +133,7 @@ public:
 
     bool loadFromXml(QXmlStreamReader &reader) override;
     void saveToXml(QXmlStreamWriter &writer) const override;
+    DrawingAbsoluteAnchor *clone(Drawing *drawing, const MediaFileMap &media) const override;
 };
 
 class DrawingOneCellAnchor : public DrawingAnchor
@@ -140,6 +149,7 @@ public:
 
     bool loadFromXml(QXmlStreamReader &reader) override;
     void saveToXml(QXmlStreamWriter &writer) const override;
+    DrawingOneCellAnchor *clone(Drawing *drawing, const MediaFileMap &media) const override;
 };
 
 class DrawingTwoCellAnchor : public DrawingAnchor
@@ -155,6 +165,7 @@ public:
 
     bool loadFromXml(QXmlStreamReader &reader) override;
     void saveToXml(QXmlStreamWriter &writer) const override;
+    DrawingTwoCellAnchor *clone(Drawing *drawing, const MediaFileMap &media) const override;
 };
 
 QT_END_NAMESPACE_XLSX
@@ -6,8 +6,11 @@
 #include "xlsxglobal.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QString>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE_XLSX
 
 class MediaFile
@@ -41,6 +44,9 @@ protected:
     QByteArray m_hashKey;
 };
 
+// Media files of a workbook and their copies in a cloned one
+using MediaFileMap = QHash<const MediaFile *, std::shared_ptr<MediaFile>>;
+
 QT_END_NAMESPACE_XLSX
 
 #endif // QXLSX_XLSXMEDIAFILE_H
@@ -46,6 +46,8 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE_XLSX
 
 class XlsxSharedStringInfo
@@ -82,6 +84,8 @@ public:
     void saveToXmlFile(QIODevice *device) const override;
     bool loadFromXmlFile(QIODevice *device) override;
 
+    std::shared_ptr<SharedStrings> clone() const;
+
 private:
     void readString(QXmlStreamReader &reader);                            // <si>
     void readRichStringPart(QXmlStreamReader &reader, RichString &rich);  // <r>
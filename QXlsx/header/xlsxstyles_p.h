@@ -83,6 +83,9 @@ public:
 
     QColor getColorByIndex(int idx);
 
+    // Copy for a cloned workbook; the formats are shared with this one
+    std::shared_ptr<Styles> clone() const;
+
 private:
     friend class Format;
     // friend class ::StylesTest;
@@ -80,6 +80,7 @@ private:
     friend class DocumentPrivate;
 
     Workbook(Workbook::CreateFlag flag);
+    std::shared_ptr<Workbook> clone() const;
 
     void saveToXmlFile(QIODevice *device) const override;
     bool loadFromXmlFile(QIODevice *device) override;
@@ -19,6 +19,9 @@
 #include <QUrl>
 #include <QVariant>
 
+#include <functional>
+#include <vector>
+
 class WorksheetTest;
 
 QT_BEGIN_NAMESPACE_XLSX
@@ -45,6 +48,7 @@ private:
     friend class ::WorksheetTest;
     Worksheet(const QString &sheetName, int sheetId, Workbook *book, CreateFlag flag);
     Worksheet *copy(const QString &distName, int distId) const override;
+    Worksheet *clone(Workbook *book) const;
 
 public:
     ~Worksheet();
@@ -80,6 +84,24 @@ public:
                       const Format &format = Format());
     bool writeNumeric(int row, int column, double value, const Format &format = Format());
 
+    // Bulk numeric writes: n values down a column, or a rows x columns
+    // block given row by row. Formats of existing cells are kept when
+    // format is not valid, as with writeNumeric().
+    bool writeColumn(int row, int column, const double *values, size_t n, const Format &format = Format());
+    bool writeColumn(int row, int column, const float *values, size_t n, const Format &format = Format());
+    bool writeRange(int row,
+                    int column,
+                    const double *values,
+                    int rows,
+                    int columns,
+                    const Format &format = Format());
+    bool writeRange(int row,
+                    int column,
+                    const float *values,
+                    int rows,
+                    int columns,
+                    const Format &format = Format());
+
     bool writeFormula(const CellReference &row_column,
                       const CellFormula &formula,
                       const Format &format = Format(),
@@ -123,6 +145,32 @@ public:
                         const QString &display = QString(),
                         const QString &tip     = QString());
 
+    // Streamed rows are produced by a callback while the sheet is being saved
+    // and serialized straight into the sheet part, without creating cells.
+    // They are not visible to read() / cellAt(). Non-finite values leave
+    // the cell empty.
+    using RowSource = std::function<void(int row, double *values)>;
+    bool setStreamedRows(int firstRow,
+                         int firstColumn,
+                         int rowCount,
+                         int columnCount,
+                         const RowSource &source,
+                         const Format &format = Format());
+    // Columns of float data starting at (firstRow, firstColumn); shorter
+    // columns leave their remaining cells empty.
+    bool setStreamedColumns(int firstRow,
+                            int firstColumn,
+                            std::vector<std::vector<float>> columns,
+                            const Format &format = Format());
+    void clearStreamedRows();
+
+    // CS_Columnar keeps numbers without format or formula in per-column
+    // arrays instead of one Cell each. cellAt() still works, but returns
+    // a temporary Cell for such values.
+    enum CellStorage { CS_Sparse, CS_Columnar };
+    void setCellStorage(CellStorage storage);
+    CellStorage cellStorage() const;
+
     bool addDataValidation(const DataValidation &validation);
     bool addConditionalFormatting(const ConditionalFormatting &cf);
 
@@ -130,6 +178,11 @@ public:
     std::shared_ptr<Cell> cellAt(int row, int column) const;
 
     int insertImage(int row, int column, const QImage &image);
+    int insertImage(int row,
+                    int column,
+                    const QByteArray &data,
+                    const QSize &size     = QSize(),
+                    const QString &suffix = QStringLiteral("png"));
     bool getImage(int imageIndex, QImage &img);
     bool getImage(int row, int column, QImage &img);
     uint getImageCount();
@@ -17,6 +17,10 @@
 #include <QString>
 #include <QVector>
 
+#include <cmath>
+#include <map>
+#include <vector>
+
 class QXmlStreamWriter;
 class QXmlStreamReader;
 
@@ -132,6 +136,21 @@ struct XlsxColumnInfo {
     bool collapsed;
 };
 
+// Plain numbers of one column in a contiguous array; NaN marks an empty slot
+struct DenseColumn {
+    int firstRow = 0;
+    std::vector<double> values;
+    int count     = 0;    // non-empty slots
+    bool allFloat = true; // every value was written as float
+
+    int lastRow() const { return firstRow + int(values.size()) - 1; }
+    bool has(int row) const
+    {
+        return row >= firstRow && row <= lastRow() && !std::isnan(values[row - firstRow]);
+    }
+    double at(int row) const { return values[row - firstRow]; }
+};
+
 class CellTable
 {
 public:
@@ -141,45 +160,82 @@ public:
         return keys;
     }
 
-    inline QList<int> sortedRows() const
-    {
-        QList<int> keys = cells.keys();
-        std::sort(keys.begin(), keys.end());
-        return keys;
-    }
+    // Rows holding at least one cell, ascending
+    QList<int> sortedRows() const;
+    // Occupied columns of a row, ascending
+    void sortedColumns(int row, std::vector<int> &columns) const;
 
-    void setValue(int row, int column, const std::shared_ptr<Cell> &cell)
-    {
-        cells[row].insert(column, cell);
-        firstRow    = qMin(firstRow, row);
-        firstColumn = qMin(firstColumn, column);
-        lastRow     = qMin(lastRow, row);
-        lastColumn  = qMin(lastColumn, column);
-    }
+    void setValue(int row, int column, const std::shared_ptr<Cell> &cell);
 
-    std::shared_ptr<Cell> cellAt(int row, int column) const
-    {
-        return cells.value(row).value(column);
-    }
+    // Stores a plain number without a Cell in columnar mode; returns false
+    // if the column would become too sparse (the caller keeps a Cell then)
+    bool setDense(int row, int column, double value, bool isFloat);
+
+    // Cells of dense columns are created on demand, so changes made
+    // through the returned Cell are not kept; use editableCellAt() for that.
+    std::shared_ptr<Cell> cellAt(int row, int column) const;
+    // Like cellAt(), but a dense value is first moved into a Cell of its
+    // own, so the caller may change its format or formula in place.
+    std::shared_ptr<Cell> editableCellAt(int row, int column);
 
     bool contains(int row, int column) const
     {
         auto it = cells.find(row);
-        if (it != cells.end()) {
-            return it->contains(column);
-        }
-        return false;
+        if (it != cells.end() && it->contains(column))
+            return true;
+        const DenseColumn *dc = denseColumn(column);
+        return dc && dc->has(row);
     }
 
-    bool isEmpty() const { return cells.isEmpty(); }
+    bool isEmpty() const { return cells.isEmpty() && denseColumns.empty(); }
+
+    const DenseColumn *denseColumn(int column) const
+    {
+        auto it = denseColumns.find(column);
+        return it != denseColumns.end() ? &it->second : nullptr;
+    }
+
+    // Switching to columnar moves plain numbers (no format, formula or
+    // string) out of their Cells; switching back recreates the Cells.
+    void setColumnar(bool enable);
+
+    static bool isPlainNumber(const Cell &cell);
 
     // It's faster with a single QHash, but in Qt5 it's capacity limits
     // how much cells we can hold
     QHash<int, QHash<int, std::shared_ptr<Cell>>> cells;
+    // Columnar mode: plain numbers live here instead of in cells, at
+    // 8 bytes each instead of a heap Cell with a QVariant and Format
+    std::map<int, DenseColumn> denseColumns;
+    bool columnar      = false;
+    Worksheet *owner   = nullptr; // parent of Cells created on demand
     int firstRow    = -1;
     int firstColumn = -1;
     int lastRow     = -1;
     int lastColumn  = -1;
+
+    // For writers filling cells directly instead of through setValue()
+    void extendBounds(int row, int column);
+
+private:
+    void removeSparse(int row, int column);
+    void clearDense(int row, int column);
+};
+
+// Rows produced at save time instead of being stored in the cell table
+struct StreamedRows {
+    int firstRow        = 0;
+    int firstColumn     = 0;
+    int rowCount        = 0;
+    int columnCount     = 0;
+    bool singlePrecision = false; // values come from float data
+    Format format;
+    Worksheet::RowSource source;
+
+    bool isEmpty() const { return rowCount <= 0 || columnCount <= 0 || !source; }
+    int lastRow() const { return firstRow + rowCount - 1; }
+    int lastColumn() const { return firstColumn + columnCount - 1; }
+    bool containsRow(int row) const { return !isEmpty() && row >= firstRow && row <= lastRow(); }
 };
 
 class WorksheetPrivate : public AbstractSheetPrivate
@@ -192,13 +248,14 @@ public:
 
 public:
     int checkDimensions(int row, int col, bool ignore_row = false, bool ignore_col = false);
+    template <typename T>
+    bool writeNumericBlock(int row, int col, const T *values, int rows, int cols, const Format &format);
     Format cellFormat(int row, int col) const;
     QString generateDimensionString() const;
-    void calculateSpans() const;
     void splitColsInfo(int colFirst, int colLast);
     void validateDimension();
 
-    void saveXmlSheetData(QXmlStreamWriter &writer) const;
+    void saveXmlSheetData(QIODevice *device) const;
     void saveXmlCellData(QXmlStreamWriter &writer,
                          int row,
                          int col,
@@ -228,6 +285,7 @@ public:
 
 public:
     CellTable cellTable;
+    StreamedRows streamedRows;
 
     QHash<int, QHash<int, QString>> comments;
     QHash<int, QHash<int, std::shared_ptr<XlsxHyperlinkData>>> urlTable;
@@ -243,7 +301,6 @@ public:
 
     CellRange dimension;
 
-    mutable QHash<int, QString> row_spans;
     QHash<int, double> row_sizes;
     QHash<int, double> col_sizes;
 
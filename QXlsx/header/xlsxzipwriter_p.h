@@ -5,27 +5,59 @@
 
 #include "xlsxglobal.h"
 
+#include <QByteArray>
 #include <QIODevice>
 #include <QString>
 
-class QZipWriter;
-
 QT_BEGIN_NAMESPACE_XLSX
 
+class ZipWriterPrivate;
+
+/*
+  Minimal zip archive writer (deflate via zlib). Besides whole-buffer
+  entries it supports streamed entries: data written to the device returned
+  by beginFile() is compressed straight into the archive, so large parts
+  never have to exist in memory as a whole.
+
+  Entries can also be compressed without a writer, on any thread, with
+  compress() and added later with addEntry().
+ */
 class ZipWriter
 {
 public:
+    // A compressed entry ready to be written
+    struct Entry {
+        QString path;
+        QByteArray data; // deflated, or stored if that was not smaller
+        bool deflated            = false;
+        bool failed              = false;
+        quint32 crc              = 0;
+        quint32 uncompressedSize = 0;
+    };
+
+    static Entry compress(const QString &filePath, const QByteArray &data, int level = -1);
+
     explicit ZipWriter(const QString &filePath);
     explicit ZipWriter(QIODevice *device);
     ~ZipWriter();
 
-    void addFile(const QString &filePath, QIODevice *device);
-    void addFile(const QString &filePath, const QByteArray &data);
+    // level is a zlib level: 0 stores, 1 (fastest) to 9 (smallest),
+    // -1 zlib's default
+    void addFile(const QString &filePath, QIODevice *device, int level = -1);
+    void addFile(const QString &filePath, const QByteArray &data, int level = -1);
+    void addEntry(const Entry &entry);
+
+    // Only one streamed entry can be open at a time; no other entry may be
+    // added until endFile().
+    QIODevice *beginFile(const QString &filePath, int level = -1);
+    void endFile();
+
     bool error() const;
     void close();
 
 private:
-    QZipWriter *m_writer;
+    ZipWriterPrivate *d;
+    Q_DISABLE_COPY(ZipWriter)
 };
 
 QT_END_NAMESPACE_XLSX
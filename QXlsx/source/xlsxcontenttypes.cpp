@@ -22,6 +22,14 @@ ContentTypes::ContentTypes(CreateFlag flag)
     m_defaults.insert(QStringLiteral("xml"), QStringLiteral("application/xml"));
 }
 
+std::shared_ptr<ContentTypes> ContentTypes::clone() const
+{
+    auto types         = std::make_shared<ContentTypes>(F_LoadFromExists);
+    types->m_defaults  = m_defaults;
+    types->m_overrides = m_overrides;
+    return types;
+}
+
 void ContentTypes::addDefault(const QString &key, const QString &value)
 {
     m_defaults.insert(key, value);
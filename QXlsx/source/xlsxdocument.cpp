@@ -24,8 +24,14 @@
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFuture>
 #include <QPointF>
 #include <QTemporaryFile>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <atomic>
+#include <functional>
 
 /*
         From Wikipedia: The Open Packaging Conventions (OPC) is a
@@ -320,7 +326,49 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
     return true;
 }
 
-bool DocumentPrivate::savePackage(QIODevice *device) const
+CompressionPolicy::CompressionPolicy(Preset preset)
+{
+    switch (preset) {
+    case Balanced:
+        level = -1;
+        break;
+    case Fast:
+        level = 1;
+        break;
+    case Small:
+        level = 9;
+        break;
+    case StoreOnly:
+        level = 0;
+        break;
+    }
+
+    // Deflating these again costs time and saves next to nothing
+    if (preset == Balanced || preset == Fast) {
+        for (const char *suffix : {"png", "jpeg", "jpg", "gif"})
+            suffixLevels.insert(QLatin1String(suffix), 0);
+    }
+}
+
+/*!
+ * Returns the zlib level used for the package entry \a entryPath.
+ */
+int CompressionPolicy::levelFor(const QString &entryPath) const
+{
+    if (!suffixLevels.isEmpty()) {
+        const int dot = entryPath.lastIndexOf(QLatin1Char('.'));
+        if (dot >= 0) {
+            auto it = suffixLevels.constFind(entryPath.mid(dot + 1).toLower());
+            if (it != suffixLevels.constEnd())
+                return *it;
+        }
+    }
+    return level;
+}
+
+bool DocumentPrivate::savePackage(QIODevice *device,
+                                  const CompressionPolicy &policy,
+                                  const std::function<bool(int, int)> &progress) const
 {
     Q_Q(const Document);
 
@@ -328,6 +376,38 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     if (zipWriter.error())
         return false;
 
+    // Parts other than worksheets are rendered and compressed on the global
+    // thread pool while this thread registers them, streams the worksheets
+    // into the archive and then writes the finished entries in order. A job
+    // yields a part plus, when there is any, its relationships part.
+    using Entries = QList<ZipWriter::Entry>;
+    QList<QFuture<Entries>> jobs;
+    std::atomic<bool> stopped{false};
+    auto addJob = [&jobs, &stopped](std::function<Entries()> job) {
+        jobs.append(QtConcurrent::run(QThreadPool::globalInstance(), [&stopped, job] {
+            // Once the save has stopped, parts not rendered yet are skipped
+            return stopped.load() ? Entries() : job();
+        }));
+    };
+    auto compress = [&policy](const QString &path, const QByteArray &data) {
+        return ZipWriter::compress(path, data, policy.levelFor(path));
+    };
+    auto addPart = [&](const QString &path, std::function<QByteArray()> render) {
+        addJob([=] { return Entries{compress(path, render())}; });
+    };
+    // A part and the relationships it collects while being rendered
+    auto addPartWithRels = [&](const QString &path,
+                               const QString &relsPath,
+                               std::function<QByteArray()> render,
+                               Relationships *rels) {
+        addJob([=] {
+            Entries entries{compress(path, render())};
+            if (!rels->isEmpty())
+                entries.append(compress(relsPath, rels->saveToXmlData()));
+            return entries;
+        });
+    };
+
     contentTypes->clearOverrides();
 
     DocPropsApp docPropsApp(DocPropsApp::F_NewFromScratch);
@@ -343,14 +423,6 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         std::shared_ptr<AbstractSheet> sheet = worksheets[i];
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
-
-        zipWriter.addFile(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
-
-        Relationships *rel = sheet->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/worksheets/_rels/sheet%1.xml.rels").arg(i + 1),
-                              rel->saveToXmlData());
     }
 
     // save chartsheet xml files
@@ -363,44 +435,43 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
 
-        zipWriter.addFile(QStringLiteral("xl/chartsheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
-        Relationships *rel = sheet->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/chartsheets/_rels/sheet%1.xml.rels").arg(i + 1),
-                              rel->saveToXmlData());
+        addPartWithRels(QStringLiteral("xl/chartsheets/sheet%1.xml").arg(i + 1),
+                        QStringLiteral("xl/chartsheets/_rels/sheet%1.xml.rels").arg(i + 1),
+                        [sheet] { return sheet->saveToXmlData(); },
+                        sheet->relationships());
     }
 
     // save external links xml files
     for (int i = 0; i < workbook->d_func()->externalLinks.count(); ++i) {
-        SimpleOOXmlFile *link = workbook->d_func()->externalLinks[i].get();
+        std::shared_ptr<SimpleOOXmlFile> link = workbook->d_func()->externalLinks[i];
         contentTypes->addExternalLinkName(QStringLiteral("externalLink%1").arg(i + 1));
 
-        zipWriter.addFile(QStringLiteral("xl/externalLinks/externalLink%1.xml").arg(i + 1),
-                          link->saveToXmlData());
-        Relationships *rel = link->relationships();
-        if (!rel->isEmpty())
-            zipWriter.addFile(
-                QStringLiteral("xl/externalLinks/_rels/externalLink%1.xml.rels").arg(i + 1),
-                rel->saveToXmlData());
+        addPartWithRels(
+            QStringLiteral("xl/externalLinks/externalLink%1.xml").arg(i + 1),
+            QStringLiteral("xl/externalLinks/_rels/externalLink%1.xml.rels").arg(i + 1),
+            [link] { return link->saveToXmlData(); },
+            link->relationships());
     }
 
     // save workbook xml file
     contentTypes->addWorkbook();
-    zipWriter.addFile(QStringLiteral("xl/workbook.xml"), workbook->saveToXmlData());
-    zipWriter.addFile(QStringLiteral("xl/_rels/workbook.xml.rels"),
-                      workbook->relationships()->saveToXmlData());
+    Workbook *book = workbook.get();
+    addJob([=] {
+        return Entries{compress(QStringLiteral("xl/workbook.xml"), book->saveToXmlData()),
+                       compress(QStringLiteral("xl/_rels/workbook.xml.rels"),
+                                book->relationships()->saveToXmlData())};
+    });
 
     // save drawing xml files
-    for (int i = 0; i < workbook->drawings().size(); ++i) {
+    const QList<Drawing *> drawings = workbook->drawings();
+    for (int i = 0; i < drawings.size(); ++i) {
         contentTypes->addDrawingName(QStringLiteral("drawing%1").arg(i + 1));
 
-        Drawing *drawing = workbook->drawings()[i];
-        zipWriter.addFile(QStringLiteral("xl/drawings/drawing%1.xml").arg(i + 1),
-                          drawing->saveToXmlData());
-        if (!drawing->relationships()->isEmpty())
-            zipWriter.addFile(QStringLiteral("xl/drawings/_rels/drawing%1.xml.rels").arg(i + 1),
-                              drawing->relationships()->saveToXmlData());
+        Drawing *drawing = drawings[i];
+        addPartWithRels(QStringLiteral("xl/drawings/drawing%1.xml").arg(i + 1),
+                        QStringLiteral("xl/drawings/_rels/drawing%1.xml.rels").arg(i + 1),
+                        [drawing] { return drawing->saveToXmlData(); },
+                        drawing->relationships());
     }
 
     // save docProps app/core xml file
@@ -411,33 +482,38 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     }
     contentTypes->addDocPropApp();
     contentTypes->addDocPropCore();
-    zipWriter.addFile(QStringLiteral("docProps/app.xml"), docPropsApp.saveToXmlData());
-    zipWriter.addFile(QStringLiteral("docProps/core.xml"), docPropsCore.saveToXmlData());
+    addPart(QStringLiteral("docProps/app.xml"),
+            [&docPropsApp] { return docPropsApp.saveToXmlData(); });
+    addPart(QStringLiteral("docProps/core.xml"),
+            [&docPropsCore] { return docPropsCore.saveToXmlData(); });
 
     // save sharedStrings xml file
     if (!workbook->sharedStrings()->isEmpty()) {
         contentTypes->addSharedString();
-        zipWriter.addFile(QStringLiteral("xl/sharedStrings.xml"),
-                          workbook->sharedStrings()->saveToXmlData());
+        addPart(QStringLiteral("xl/sharedStrings.xml"),
+                [book] { return book->sharedStrings()->saveToXmlData(); });
     }
 
-    // save calc chain [dev16]
+    // save calc chain [dev16] and styles xml file
     contentTypes->addCalcChain();
-    zipWriter.addFile(QStringLiteral("xl/calcChain.xml"), workbook->styles()->saveToXmlData());
-
-    // save styles xml file
     contentTypes->addStyles();
-    zipWriter.addFile(QStringLiteral("xl/styles.xml"), workbook->styles()->saveToXmlData());
+    addJob([=] {
+        const QByteArray styles = book->styles()->saveToXmlData();
+        return Entries{compress(QStringLiteral("xl/calcChain.xml"), styles),
+                       compress(QStringLiteral("xl/styles.xml"), styles)};
+    });
 
     // save theme xml file
     contentTypes->addTheme();
-    zipWriter.addFile(QStringLiteral("xl/theme/theme1.xml"), workbook->theme()->saveToXmlData());
+    addPart(QStringLiteral("xl/theme/theme1.xml"),
+            [book] { return book->theme()->saveToXmlData(); });
 
     // save chart xml files
     for (int i = 0; i < workbook->chartFiles().size(); ++i) {
         contentTypes->addChartName(QStringLiteral("chart%1").arg(i + 1));
         std::shared_ptr<Chart> cf = workbook->chartFiles()[i];
-        zipWriter.addFile(QStringLiteral("xl/charts/chart%1.xml").arg(i + 1), cf->saveToXmlData());
+        addPart(QStringLiteral("xl/charts/chart%1.xml").arg(i + 1),
+                [cf] { return cf->saveToXmlData(); });
     }
 
     // save image files
@@ -447,25 +523,67 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         if (!mf->mimeType().isEmpty())
             contentTypes->addDefault(mf->suffix(), mf->mimeType());
 
-        zipWriter.addFile(QStringLiteral("xl/media/image%1.%2").arg(i + 1).arg(mf->suffix()),
-                          mf->contents());
+        addPart(QStringLiteral("xl/media/image%1.%2").arg(i + 1).arg(mf->suffix()),
+                [mf] { return mf->contents(); });
     }
 
     // save root .rels xml file
-    Relationships rootrels;
-    rootrels.addDocumentRelationship(QStringLiteral("/officeDocument"),
-                                     QStringLiteral("xl/workbook.xml"));
-    rootrels.addPackageRelationship(QStringLiteral("/metadata/core-properties"),
-                                    QStringLiteral("docProps/core.xml"));
-    rootrels.addDocumentRelationship(QStringLiteral("/extended-properties"),
-                                     QStringLiteral("docProps/app.xml"));
-    zipWriter.addFile(QStringLiteral("_rels/.rels"), rootrels.saveToXmlData());
+    addPart(QStringLiteral("_rels/.rels"), [] {
+        Relationships rootrels;
+        rootrels.addDocumentRelationship(QStringLiteral("/officeDocument"),
+                                         QStringLiteral("xl/workbook.xml"));
+        rootrels.addPackageRelationship(QStringLiteral("/metadata/core-properties"),
+                                        QStringLiteral("docProps/core.xml"));
+        rootrels.addDocumentRelationship(QStringLiteral("/extended-properties"),
+                                         QStringLiteral("docProps/app.xml"));
+        return rootrels.saveToXmlData();
+    });
 
     // save content types xml file
-    zipWriter.addFile(QStringLiteral("[Content_Types].xml"), contentTypes->saveToXmlData());
+    std::shared_ptr<ContentTypes> types = contentTypes;
+    addPart(QStringLiteral("[Content_Types].xml"), [types] { return types->saveToXmlData(); });
+
+    const int partCount = int(worksheets.size() + jobs.size());
+    int partsWritten    = 0;
+    auto partWritten    = [&] {
+        ++partsWritten;
+        if (progress && !progress(partsWritten, partCount))
+            stopped = true;
+    };
+
+    // Worksheets are deflated into the archive while they are serialized,
+    // in order on this thread, so the largest parts never exist in memory
+    // as a whole.
+    for (int i = 0; i < worksheets.size() && !stopped && !zipWriter.error(); ++i) {
+        AbstractSheet *sheet = worksheets[i].get();
+        const QString path   = QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1);
+        sheet->saveToXmlFile(zipWriter.beginFile(path, policy.levelFor(path)));
+        zipWriter.endFile();
+
+        Relationships *rels = sheet->relationships();
+        if (!rels->isEmpty()) {
+            const QString relsPath =
+                QStringLiteral("xl/worksheets/_rels/sheet%1.xml.rels").arg(i + 1);
+            zipWriter.addFile(relsPath, rels->saveToXmlData(), policy.levelFor(relsPath));
+        }
+        partWritten();
+    }
+
+    // Every job is waited for, also after a write error or a stop, since
+    // they use this document; addEntry() does nothing once the writer has
+    // failed.
+    for (QFuture<Entries> &job : jobs) {
+        const Entries entries = job.result();
+        job                   = QFuture<Entries>(); // drop the compressed data
+        if (stopped)
+            continue;
+        for (const ZipWriter::Entry &entry : entries)
+            zipWriter.addEntry(entry);
+        partWritten();
+    }
 
     zipWriter.close();
-    return true;
+    return !stopped && !zipWriter.error();
 }
 
 //
@@ -699,6 +817,31 @@ Document::Document(QIODevice *device, QObject *parent)
     d_ptr->init();
 }
 
+/*!
+ * Returns a copy of this document that can be filled and saved on its own,
+ * e.g. a loaded template, without loading the package again. Strings,
+ * formats, cell values, theme and media are implicitly shared with this
+ * document until one of them changes, so a clone is cheap.
+ * The copy has no package name; save it with saveAs().
+ * Returns nullptr if the workbook holds charts, chartsheets or external
+ * links, which cannot be copied.
+ */
+Document *Document::clone(QObject *parent) const
+{
+    Q_D(const Document);
+    std::shared_ptr<Workbook> book = d->workbook->clone();
+    if (!book)
+        return nullptr;
+
+    auto doc                  = new Document(parent);
+    DocumentPrivate *doc_d    = doc->d_func();
+    doc_d->workbook           = book;
+    doc_d->contentTypes       = d->contentTypes->clone();
+    doc_d->documentProperties = d->documentProperties;
+    doc_d->isLoad             = d->isLoad;
+    return doc;
+}
+
 /*!
         \overload
 
@@ -759,6 +902,22 @@ int Document::insertImage(int row, int column, const QImage &image)
     return 0;
 }
 
+/*!
+ * \overload
+ * Insert the already encoded image \a data, see Worksheet::insertImage().
+ */
+int Document::insertImage(int row,
+                          int column,
+                          const QByteArray &data,
+                          const QSize &size,
+                          const QString &suffix)
+{
+    if (Worksheet *sheet = currentWorksheet())
+        return sheet->insertImage(row, column, data, size, suffix);
+
+    return 0;
+}
+
 bool Document::getImage(int imageIndex, QImage &img)
 {
     if (Worksheet *sheet = currentWorksheet())
@@ -1352,23 +1511,58 @@ bool Document::save() const
  * Returns true if saved successfully.
  */
 bool Document::saveAs(const QString &name) const
+{
+    return saveAs(name, CompressionPolicy());
+}
+
+/*!
+ * \overload
+ * This function writes a document to the given \a device, which must be
+ * open for writing. The \a device is left open.
+ */
+bool Document::saveAs(QIODevice *device) const
+{
+    return saveAs(device, CompressionPolicy());
+}
+
+/*!
+ * \overload
+ * Saves the document to the file with the given \a name, compressing its
+ * parts as the \a policy says.
+ */
+bool Document::saveAs(const QString &name, const CompressionPolicy &policy) const
 {
     QFile file(name);
     if (file.open(QIODevice::WriteOnly))
-        return saveAs(&file);
+        return saveAs(&file, policy);
     return false;
 }
 
 /*!
  * \overload
- * This function writes a document to the given \a device.
- *
- * \warning The \a device will be closed when this function returned.
+ * Writes the document to the given \a device, compressing its parts as
+ * the \a policy says.
  */
-bool Document::saveAs(QIODevice *device) const
+bool Document::saveAs(QIODevice *device, const CompressionPolicy &policy) const
+{
+    Q_D(const Document);
+    return d->savePackage(device, policy);
+}
+
+/*!
+ * \overload
+ * Writes the document to the given \a device like the overload above and
+ * calls \a progress with the number of parts written so far and the total
+ * after each part. When \a progress returns false the save stops: the
+ * \a device is left with an incomplete archive and false is returned.
+ * \a progress is called on the calling thread.
+ */
+bool Document::saveAs(QIODevice *device,
+                      const CompressionPolicy &policy,
+                      const std::function<bool(int, int)> &progress) const
 {
     Q_D(const Document);
-    return d->savePackage(device);
+    return d->savePackage(device, policy, progress);
 }
 
 bool Document::saveAsCsv(const QString mainCSVFileName) const
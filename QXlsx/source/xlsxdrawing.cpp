@@ -22,6 +22,14 @@ Drawing::~Drawing()
     qDeleteAll(anchors);
 }
 
+std::shared_ptr<Drawing> Drawing::clone(AbstractSheet *sheet, const MediaFileMap &media) const
+{
+    auto drawing = std::make_shared<Drawing>(sheet, F_LoadFromExists);
+    for (const DrawingAnchor *anchor : anchors)
+        anchor->clone(drawing.get(), media);
+    return drawing;
+}
+
 void Drawing::saveToXmlFile(QIODevice *device) const
 {
     relationships()->clear();
@@ -60,6 +60,14 @@ DrawingAnchor::~DrawingAnchor()
 {
 }
 
+void DrawingAnchor::attachClone(Drawing *drawing, const MediaFileMap &media)
+{
+    m_drawing = drawing;
+    m_drawing->anchors.append(this);
+    if (m_pictureFile)
+        m_pictureFile = media.value(m_pictureFile.get());
+}
+
 void DrawingAnchor::setObjectPicture(const QImage &img)
 {
     QByteArray ba;
@@ -67,8 +75,16 @@ void DrawingAnchor::setObjectPicture(const QImage &img)
     buffer.open(QIODevice::WriteOnly);
     img.save(&buffer, "PNG");
 
-    m_pictureFile =
-        std::make_shared<MediaFile>(ba, QStringLiteral("png"), QStringLiteral("image/png"));
+    setObjectPicture(ba, QStringLiteral("png"));
+}
+
+void DrawingAnchor::setObjectPicture(const QByteArray &data, const QString &suffix)
+{
+    const QString format = suffix.toLower();
+    const QString mimeType = QStringLiteral("image/") +
+                             (format == QLatin1String("jpg") ? QStringLiteral("jpeg") : format);
+
+    m_pictureFile = std::make_shared<MediaFile>(data, format, mimeType);
     m_drawing->workbook->addMediaFile(m_pictureFile);
 
     m_objectType = Picture;
@@ -993,6 +1009,13 @@ DrawingAbsoluteAnchor::DrawingAbsoluteAnchor(Drawing *drawing, ObjectType object
 {
 }
 
+DrawingAbsoluteAnchor *DrawingAbsoluteAnchor::clone(Drawing *drawing, const MediaFileMap &media) const
+{
+    auto anchor = new DrawingAbsoluteAnchor(*this);
+    anchor->attachClone(drawing, media);
+    return anchor;
+}
+
 // check point
 bool DrawingAbsoluteAnchor::loadFromXml(QXmlStreamReader &reader)
 {
@@ -1035,6 +1058,13 @@ DrawingOneCellAnchor::DrawingOneCellAnchor(Drawing *drawing, ObjectType objectTy
 {
 }
 
+DrawingOneCellAnchor *DrawingOneCellAnchor::clone(Drawing *drawing, const MediaFileMap &media) const
+{
+    auto anchor = new DrawingOneCellAnchor(*this);
+    anchor->attachClone(drawing, media);
+    return anchor;
+}
+
 int DrawingOneCellAnchor::row() const
 {
     return from.row();
@@ -1093,6 +1123,13 @@ DrawingTwoCellAnchor::DrawingTwoCellAnchor(Drawing *drawing, ObjectType objectTy
 {
 }
 
+DrawingTwoCellAnchor *DrawingTwoCellAnchor::clone(Drawing *drawing, const MediaFileMap &media) const
+{
+    auto anchor = new DrawingTwoCellAnchor(*this);
+    anchor->attachClone(drawing, media);
+    return anchor;
+}
+
 int DrawingTwoCellAnchor::row() const
 {
     return from.row();
@@ -34,6 +34,15 @@ int SharedStrings::count() const
     return m_stringCount;
 }
 
+std::shared_ptr<SharedStrings> SharedStrings::clone() const
+{
+    auto strings           = std::make_shared<SharedStrings>(F_LoadFromExists);
+    strings->m_stringTable = m_stringTable;
+    strings->m_stringList  = m_stringList;
+    strings->m_stringCount = m_stringCount;
+    return strings;
+}
+
 bool SharedStrings::isEmpty() const
 {
     return m_stringList.isEmpty();
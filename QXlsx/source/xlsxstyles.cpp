@@ -72,6 +72,30 @@ Styles::~Styles()
 {
 }
 
+std::shared_ptr<Styles> Styles::clone() const
+{
+    auto styles = std::make_shared<Styles>(F_LoadFromExists);
+
+    styles->m_builtinNumFmtsHash     = m_builtinNumFmtsHash;
+    styles->m_customNumFmtIdMap      = m_customNumFmtIdMap;
+    styles->m_customNumFmtsHash      = m_customNumFmtsHash;
+    styles->m_nextCustomNumFmtId     = m_nextCustomNumFmtId;
+    styles->m_fontsList              = m_fontsList;
+    styles->m_fillsList              = m_fillsList;
+    styles->m_bordersList            = m_bordersList;
+    styles->m_fontsHash              = m_fontsHash;
+    styles->m_fillsHash              = m_fillsHash;
+    styles->m_bordersHash            = m_bordersHash;
+    styles->m_indexedColors          = m_indexedColors;
+    styles->m_isIndexedColorsDefault = m_isIndexedColorsDefault;
+    styles->m_xf_formatsList         = m_xf_formatsList;
+    styles->m_xf_formatsHash         = m_xf_formatsHash;
+    styles->m_dxf_formatsList        = m_dxf_formatsList;
+    styles->m_dxf_formatsHash        = m_dxf_formatsHash;
+    styles->m_emptyFormatAdded       = m_emptyFormatAdded;
+    return styles;
+}
+
 Format Styles::xfFormat(int idx) const
 {
     if (idx < 0 || idx >= m_xf_formatsList.size())
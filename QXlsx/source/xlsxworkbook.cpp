@@ -4,11 +4,13 @@
 
 #include "xlsxchart.h"
 #include "xlsxchartsheet.h"
+#include "xlsxdrawing_p.h"
 #include "xlsxformat.h"
 #include "xlsxformat_p.h"
 #include "xlsxmediafile_p.h"
 #include "xlsxsharedstrings_p.h"
 #include "xlsxstyles_p.h"
+#include "xlsxtheme_p.h"
 #include "xlsxutility_p.h"
 #include "xlsxworkbook_p.h"
 #include "xlsxworksheet.h"
@@ -58,6 +60,64 @@ Workbook::~Workbook()
 {
 }
 
+/*!
+ * \internal
+ * Returns an independent copy of this workbook, or nullptr if it holds
+ * charts, chartsheets or external links, which cannot be copied yet.
+ * The copy shares strings, formats, cell values, theme and media bytes
+ * with this workbook through Qt's implicit sharing, so it costs little
+ * more than the objects it holds.
+ */
+std::shared_ptr<Workbook> Workbook::clone() const
+{
+    Q_D(const Workbook);
+    if (!d->chartFiles.isEmpty() || !d->externalLinks.isEmpty() ||
+        !getSheetsByTypes(AbstractSheet::ST_ChartSheet).isEmpty())
+        return nullptr;
+
+    auto book               = std::shared_ptr<Workbook>(new Workbook(d->flag));
+    WorkbookPrivate *book_d = book->d_func();
+
+    book_d->sharedStrings    = d->sharedStrings->clone();
+    book_d->styles           = d->styles->clone();
+    book_d->theme->xmlData   = d->theme->xmlData;
+    book_d->sheetNames       = d->sheetNames;
+    book_d->definedNamesList = d->definedNamesList;
+
+    book_d->strings_to_numbers_enabled    = d->strings_to_numbers_enabled;
+    book_d->strings_to_hyperlinks_enabled = d->strings_to_hyperlinks_enabled;
+    book_d->html_to_richstring_enabled    = d->html_to_richstring_enabled;
+    book_d->date1904                      = d->date1904;
+    book_d->defaultDateFormat             = d->defaultDateFormat;
+    book_d->x_window                      = d->x_window;
+    book_d->y_window                      = d->y_window;
+    book_d->window_width                  = d->window_width;
+    book_d->window_height                 = d->window_height;
+    book_d->activesheetIndex              = d->activesheetIndex;
+    book_d->firstsheet                    = d->firstsheet;
+    book_d->table_count                   = d->table_count;
+    book_d->last_worksheet_index          = d->last_worksheet_index;
+    book_d->last_chartsheet_index         = d->last_chartsheet_index;
+    book_d->last_sheet_id                 = d->last_sheet_id;
+
+    MediaFileMap media;
+    for (const auto &mf : d->mediaFiles) {
+        auto copy = std::make_shared<MediaFile>(*mf);
+        media.insert(mf.get(), copy);
+        book_d->mediaFiles.append(copy);
+    }
+
+    for (const auto &sheet : d->sheets) {
+        auto worksheet = std::static_pointer_cast<Worksheet>(sheet);
+        std::shared_ptr<AbstractSheet> copy(worksheet->clone(book.get()));
+        if (sheet->d_func()->drawing)
+            copy->d_func()->drawing = sheet->d_func()->drawing->clone(copy.get(), media);
+        book_d->sheets.append(copy);
+    }
+
+    return book;
+}
+
 bool Workbook::isDate1904() const
 {
     Q_D(const Workbook);
@@ -22,7 +22,12 @@
 #include "xlsxworkbook.h"
 #include "xlsxworksheet_p.h"
 
+#include <algorithm>
+#include <charconv>
+#include <climits>
 #include <cmath>
+#include <string>
+#include <type_traits>
 
 #include <QBuffer>
 #include <QDate>
@@ -30,6 +35,7 @@
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QImageReader>
 #include <QMap>
 #include <QMapIterator>
 #include <QPoint>
@@ -46,6 +52,39 @@ namespace {
 const int XLSX_ROW_MAX    = 1048576;
 const int XLSX_COLUMN_MAX = 16384;
 const int XLSX_STRING_MAX = 32767;
+
+const size_t SheetDataFlushSize = 64 * 1024;
+
+void appendInt(std::string &out, int value)
+{
+    char buf[16];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr - buf);
+}
+
+// A1-style reference of (row, col)
+void appendCellReference(std::string &out, int row, int col)
+{
+    char letters[4];
+    int n = 0;
+    for (; col > 0; col = (col - 1) / 26)
+        letters[n++] = char('A' + (col - 1) % 26);
+    while (n > 0)
+        out.push_back(letters[--n]);
+    appendInt(out, row);
+}
+
+// Same digits as QString::number(value, 'g', 15); floats get the shortest
+// representation that round-trips
+void appendNumber(std::string &out, double value, bool singlePrecision)
+{
+    char buf[32];
+    const auto res =
+        singlePrecision
+            ? std::to_chars(buf, buf + sizeof(buf), float(value))
+            : std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 15);
+    out.append(buf, res.ptr - buf);
+}
 } // namespace
 
 WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
@@ -62,67 +101,204 @@ WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
     , showWhiteSpace(true)
     , urlPattern(QStringLiteral("^([fh]tt?ps?://)|(mailto:)|(file://)"))
 {
+    cellTable.owner = p;
 }
 
 WorksheetPrivate::~WorksheetPrivate()
 {
 }
 
-/*
-  Calculate the "spans" attribute of the <row> tag. This is an
-  XLSX optimisation and isn't strictly required. However, it
-  makes comparing files easier. The span is the same for each
-  block of 16 rows.
- */
-void WorksheetPrivate::calculateSpans() const
-{
-    row_spans.clear();
-    int span_min = XLSX_COLUMN_MAX + 1;
-    int span_max = -1;
-
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-            if (cellTable.contains(row_num, col_num)) {
-                if (span_max == -1) {
-                    span_min = col_num;
-                    span_max = col_num;
-                } else {
-                    if (col_num < span_min)
-                        span_min = col_num;
-                    else if (col_num > span_max)
-                        span_max = col_num;
-                }
-            }
+QList<int> CellTable::sortedRows() const
+{
+    QList<int> keys = cells.keys();
+    for (const auto &entry : denseColumns) {
+        const DenseColumn &dc = entry.second;
+        for (size_t i = 0; i < dc.values.size(); ++i) {
+            if (!std::isnan(dc.values[i]))
+                keys.append(dc.firstRow + int(i));
         }
+    }
+    std::sort(keys.begin(), keys.end());
+    if (!denseColumns.empty())
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
 
-        auto cIt = comments.constFind(row_num);
-        if (cIt != comments.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (cIt->contains(col_num)) {
-                    if (span_max == -1) {
-                        span_min = col_num;
-                        span_max = col_num;
-                    } else {
-                        if (col_num < span_min)
-                            span_min = col_num;
-                        else if (col_num > span_max)
-                            span_max = col_num;
-                    }
-                }
+void CellTable::sortedColumns(int row, std::vector<int> &columns) const
+{
+    columns.clear();
+    auto it = cells.constFind(row);
+    if (it != cells.constEnd()) {
+        for (auto c = it->keyBegin(); c != it->keyEnd(); ++c)
+            columns.push_back(*c);
+    }
+    for (const auto &entry : denseColumns) {
+        if (entry.second.has(row))
+            columns.push_back(entry.first);
+    }
+    std::sort(columns.begin(), columns.end());
+    if (!denseColumns.empty())
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+}
+
+void CellTable::setValue(int row, int column, const std::shared_ptr<Cell> &cell)
+{
+    if (columnar && isPlainNumber(*cell) &&
+        setDense(row, column, cell->value().toDouble(),
+                 cell->value().userType() == QMetaType::Float))
+        return;
+
+    clearDense(row, column);
+    cells[row].insert(column, cell);
+    extendBounds(row, column);
+}
+
+bool CellTable::setDense(int row, int column, double value, bool isFloat)
+{
+    if (std::isnan(value))
+        return false;
+
+    DenseColumn &dc = denseColumns[column];
+    if (dc.values.empty()) {
+        dc.firstRow = row;
+        dc.values.assign(1, std::nan(""));
+    } else if (row < dc.firstRow || row > dc.lastRow()) {
+        const int first   = qMin(row, dc.firstRow);
+        const size_t size = size_t(qMax(row, dc.lastRow()) - first + 1);
+        // keep at least about a quarter of the slots in use
+        if (size > 4 * size_t(dc.count + 1) + 1024)
+            return false;
+        if (row < dc.firstRow)
+            dc.values.insert(dc.values.begin(), size_t(dc.firstRow - row), std::nan(""));
+        else
+            dc.values.resize(size, std::nan(""));
+        dc.firstRow = first;
+    }
+
+    double &slot = dc.values[row - dc.firstRow];
+    if (std::isnan(slot))
+        ++dc.count;
+    slot        = value;
+    dc.allFloat = dc.allFloat && isFloat;
+
+    removeSparse(row, column);
+    extendBounds(row, column);
+    return true;
+}
+
+std::shared_ptr<Cell> CellTable::cellAt(int row, int column) const
+{
+    auto it = cells.constFind(row);
+    if (it != cells.constEnd()) {
+        auto c = it->constFind(column);
+        if (c != it->constEnd())
+            return *c;
+    }
+
+    const DenseColumn *dc = denseColumn(column);
+    if (!dc || !dc->has(row))
+        return nullptr;
+    const double value = dc->at(row);
+    return std::make_shared<Cell>(dc->allFloat ? QVariant(float(value)) : QVariant(value),
+                                  Cell::NumberType,
+                                  Format(),
+                                  owner);
+}
+
+std::shared_ptr<Cell> CellTable::editableCellAt(int row, int column)
+{
+    auto it = cells.find(row);
+    if (it != cells.end()) {
+        auto c = it->find(column);
+        if (c != it->end())
+            return *c;
+    }
+
+    auto cell = cellAt(row, column);
+    if (cell) {
+        clearDense(row, column);
+        cells[row].insert(column, cell);
+    }
+    return cell;
+}
+
+void CellTable::setColumnar(bool enable)
+{
+    if (enable == columnar)
+        return;
+    columnar = enable;
+
+    if (enable) {
+        // (column, row) order, so dense columns only grow at the end
+        std::vector<std::pair<int, int>> plain;
+        for (auto r = cells.constBegin(); r != cells.constEnd(); ++r) {
+            for (auto c = r->constBegin(); c != r->constEnd(); ++c) {
+                if (isPlainNumber(**c))
+                    plain.emplace_back(c.key(), r.key());
             }
         }
-
-        if (row_num % 16 == 0 || row_num == dimension.lastRow()) {
-            if (span_max != -1) {
-                row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-                span_min                = XLSX_COLUMN_MAX + 1;
-                span_max                = -1;
+        std::sort(plain.begin(), plain.end());
+        for (const auto &cr : plain) {
+            const QVariant value = cells[cr.second][cr.first]->value();
+            setDense(cr.second, cr.first, value.toDouble(), value.userType() == QMetaType::Float);
+        }
+    } else {
+        const std::map<int, DenseColumn> dense = std::move(denseColumns);
+        denseColumns.clear();
+        for (const auto &entry : dense) {
+            const DenseColumn &dc = entry.second;
+            for (int row = dc.firstRow; row <= dc.lastRow(); ++row) {
+                if (!dc.has(row))
+                    continue;
+                const QVariant value =
+                    dc.allFloat ? QVariant(float(dc.at(row))) : QVariant(dc.at(row));
+                cells[row].insert(entry.first,
+                                  std::make_shared<Cell>(value, Cell::NumberType, Format(), owner));
             }
         }
     }
 }
 
+bool CellTable::isPlainNumber(const Cell &cell)
+{
+    if (cell.cellType() != Cell::NumberType || cell.hasFormula() || cell.isRichString() ||
+        !cell.format().isEmpty())
+        return false;
+    const int type = cell.value().userType();
+    return type == QMetaType::Double || type == QMetaType::Float || type == QMetaType::Int;
+}
+
+void CellTable::removeSparse(int row, int column)
+{
+    auto it = cells.find(row);
+    if (it == cells.end())
+        return;
+    it->remove(column);
+    if (it->isEmpty())
+        cells.erase(it);
+}
+
+void CellTable::clearDense(int row, int column)
+{
+    auto it = denseColumns.find(column);
+    if (it == denseColumns.end() || !it->second.has(row))
+        return;
+    DenseColumn &dc                = it->second;
+    dc.values[row - dc.firstRow] = std::nan("");
+    if (--dc.count == 0)
+        denseColumns.erase(it);
+}
+
+void CellTable::extendBounds(int row, int column)
+{
+    if (firstRow == -1 || row < firstRow)
+        firstRow = row;
+    if (firstColumn == -1 || column < firstColumn)
+        firstColumn = column;
+    lastRow    = qMax(lastRow, row);
+    lastColumn = qMax(lastColumn, column);
+}
+
 QString WorksheetPrivate::generateDimensionString() const
 {
     if (!dimension.isValid())
@@ -217,6 +393,13 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
     //     sheet_d->cellTable.setValue(CellTable::row(it.key()), CellTable::column(it.key()), cell);
     // }
 
+    sheet_d->cellTable.columnar     = d->cellTable.columnar;
+    sheet_d->cellTable.denseColumns = d->cellTable.denseColumns;
+    sheet_d->cellTable.firstRow     = d->cellTable.firstRow;
+    sheet_d->cellTable.firstColumn  = d->cellTable.firstColumn;
+    sheet_d->cellTable.lastRow      = d->cellTable.lastRow;
+    sheet_d->cellTable.lastColumn   = d->cellTable.lastColumn;
+    sheet_d->streamedRows = d->streamedRows;
     sheet_d->merges = d->merges;
     //    sheet_d->rowsInfo = d->rowsInfo;
     //    sheet_d->colsInfo = d->colsInfo;
@@ -227,6 +410,86 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
     return sheet;
 }
 
+/*!
+ * \internal
+ *
+ * Make a copy of this sheet, with the same name and id, for the cloned
+ * workbook \a book. Cells are copied; their values and formats, like
+ * the rest of the sheet, are implicitly shared with this sheet. The
+ * drawing is copied by Workbook::clone().
+ */
+Worksheet *Worksheet::clone(Workbook *book) const
+{
+    Q_D(const Worksheet);
+    auto sheet                = new Worksheet(d->name, d->id, book, d->flag);
+    WorksheetPrivate *sheet_d = sheet->d_func();
+
+    sheet_d->sheetState = d->sheetState;
+
+    sheet_d->cellTable = d->cellTable;
+    sheet_d->cellTable.owner = sheet;
+    for (auto &row : sheet_d->cellTable.cells) {
+        for (auto &cell : row) {
+            cell                = std::make_shared<Cell>(cell.get());
+            cell->d_ptr->parent = sheet;
+        }
+    }
+    sheet_d->streamedRows = d->streamedRows;
+
+    sheet_d->comments  = d->comments;
+    sheet_d->urlTable  = d->urlTable;
+    sheet_d->merges    = d->merges;
+    sheet_d->dimension = d->dimension;
+    for (auto it = d->rowsInfo.constBegin(); it != d->rowsInfo.constEnd(); ++it)
+        sheet_d->rowsInfo.insert(it.key(), std::make_shared<XlsxRowInfo>(*it.value()));
+    // colsInfoHelper maps every column to its entry of colsInfo
+    for (auto it = d->colsInfo.constBegin(); it != d->colsInfo.constEnd(); ++it) {
+        auto info = std::make_shared<XlsxColumnInfo>(*it.value());
+        sheet_d->colsInfo.insert(it.key(), info);
+        for (int col = info->firstColumn; col <= info->lastColumn; ++col)
+            sheet_d->colsInfoHelper.insert(col, info);
+    }
+
+    sheet_d->dataValidationsList       = d->dataValidationsList;
+    sheet_d->conditionalFormattingList = d->conditionalFormattingList;
+    sheet_d->sharedFormulaMap          = d->sharedFormulaMap;
+    sheet_d->row_sizes                 = d->row_sizes;
+    sheet_d->col_sizes                 = d->col_sizes;
+
+    sheet_d->PpaperSize           = d->PpaperSize;
+    sheet_d->Pscale               = d->Pscale;
+    sheet_d->PfirstPageNumber     = d->PfirstPageNumber;
+    sheet_d->Porientation         = d->Porientation;
+    sheet_d->PuseFirstPageNumber  = d->PuseFirstPageNumber;
+    sheet_d->PhorizontalDpi       = d->PhorizontalDpi;
+    sheet_d->PverticalDpi         = d->PverticalDpi;
+    sheet_d->Prid                 = d->Prid;
+    sheet_d->Pcopies              = d->Pcopies;
+    sheet_d->PMheader             = d->PMheader;
+    sheet_d->PMfooter             = d->PMfooter;
+    sheet_d->PMtop                = d->PMtop;
+    sheet_d->PMbotton             = d->PMbotton;
+    sheet_d->PMleft               = d->PMleft;
+    sheet_d->PMright              = d->PMright;
+    sheet_d->MoodFooter           = d->MoodFooter;
+    sheet_d->ModdHeader           = d->ModdHeader;
+    sheet_d->MoodalignWithMargins = d->MoodalignWithMargins;
+
+    sheet_d->sheetFormatProps   = d->sheetFormatProps;
+    sheet_d->windowProtection   = d->windowProtection;
+    sheet_d->showFormulas       = d->showFormulas;
+    sheet_d->showGridLines      = d->showGridLines;
+    sheet_d->showRowColHeaders  = d->showRowColHeaders;
+    sheet_d->showZeros          = d->showZeros;
+    sheet_d->rightToLeft        = d->rightToLeft;
+    sheet_d->tabSelected        = d->tabSelected;
+    sheet_d->showRuler          = d->showRuler;
+    sheet_d->showOutlineSymbols = d->showOutlineSymbols;
+    sheet_d->showWhiteSpace     = d->showWhiteSpace;
+
+    return sheet;
+}
+
 /*!
  * Destroys this workssheet.
  */
@@ -558,6 +821,22 @@ std::shared_ptr<Cell> Worksheet::cellAt(const CellReference &row_column) const
     return cellAt(row_column.row(), row_column.column());
 }
 
+/*!
+  Sets how plain numeric cells are stored. Switching converts the cells
+  already written.
+ */
+void Worksheet::setCellStorage(CellStorage storage)
+{
+    Q_D(Worksheet);
+    d->cellTable.setColumnar(storage == CS_Columnar);
+}
+
+Worksheet::CellStorage Worksheet::cellStorage() const
+{
+    Q_D(const Worksheet);
+    return d->cellTable.columnar ? CS_Columnar : CS_Sparse;
+}
+
 /*!
  * Returns the cell at the given \a row and \a column. If there
  * is no cell at the specified position, the function returns 0.
@@ -726,6 +1005,138 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
     return true;
 }
 
+/*!
+  Write \a rows x \a cols numbers from \a values (row by row) to the block
+  starting at (\a row, \a col). One row lookup per row instead of a
+  QVariant dispatch, cell reference and format lookup per cell.
+ */
+template <typename T>
+bool WorksheetPrivate::writeNumericBlock(int row,
+                                         int col,
+                                         const T *values,
+                                         int rows,
+                                         int cols,
+                                         const Format &format)
+{
+    Q_Q(Worksheet);
+    if (rows <= 0 || cols <= 0)
+        return true;
+    if (checkDimensions(row, col) || checkDimensions(row + rows - 1, col + cols - 1))
+        return false;
+
+    if (format.isValid())
+        workbook->styles()->addXfFormat(format);
+    else
+        workbook->styles()->addXfFormat(Format());
+
+    if (cellTable.columnar) {
+        // setValue()/setDense() keep a cell in either the dense or the
+        // sparse storage, never in both
+        const bool isFloat = std::is_same<T, float>::value;
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                const T value = values[size_t(r) * cols + c];
+                // a formatted cell keeps its Cell; so does a value that
+                // would leave the column too sparse
+                Format fmt = format;
+                if (!fmt.isValid()) {
+                    auto rIt = cellTable.cells.constFind(row + r);
+                    if (rIt != cellTable.cells.constEnd()) {
+                        auto cIt = rIt->constFind(col + c);
+                        if (cIt != rIt->constEnd())
+                            fmt = (*cIt)->format();
+                    }
+                    if (fmt.isValid())
+                        workbook->styles()->addXfFormat(fmt);
+                }
+                if (fmt.isEmpty() && cellTable.setDense(row + r, col + c, double(value), isFloat))
+                    continue;
+                cellTable.setValue(
+                    row + r, col + c, std::make_shared<Cell>(QVariant(value), Cell::NumberType, fmt, q));
+            }
+        }
+        return true;
+    }
+
+    cellTable.cells.reserve(cellTable.cells.size() + rows);
+    for (int r = 0; r < rows; ++r) {
+        auto &rowCells = cellTable.cells[row + r];
+        rowCells.reserve(rowCells.size() + cols);
+        for (int c = 0; c < cols; ++c) {
+            Format fmt = format;
+            if (!fmt.isValid() && !rowCells.isEmpty()) {
+                // keep the format of a cell being overwritten
+                auto it = rowCells.constFind(col + c);
+                if (it != rowCells.constEnd() && (*it)->format().isValid()) {
+                    fmt = (*it)->format();
+                    workbook->styles()->addXfFormat(fmt);
+                }
+            }
+            rowCells.insert(
+                col + c,
+                std::make_shared<Cell>(QVariant(values[size_t(r) * cols + c]), Cell::NumberType, fmt, q));
+        }
+    }
+    // Cells went in directly, bypassing setValue(): the corners bound the block
+    cellTable.extendBounds(row, col);
+    cellTable.extendBounds(row + rows - 1, col + cols - 1);
+    return true;
+}
+
+/*!
+  Write \a n numbers down the column starting at (\a row, \a column) with
+  the \a format. Returns true on success.
+ */
+bool Worksheet::writeColumn(int row, int column, const double *values, size_t n, const Format &format)
+{
+    Q_D(Worksheet);
+    if (n > size_t(XLSX_ROW_MAX))
+        return false;
+    return d->writeNumericBlock(row, column, values, int(n), 1, format);
+}
+
+/*!
+  \overload
+  Float values are kept as float, so they are saved with their shortest
+  representation.
+ */
+bool Worksheet::writeColumn(int row, int column, const float *values, size_t n, const Format &format)
+{
+    Q_D(Worksheet);
+    if (n > size_t(XLSX_ROW_MAX))
+        return false;
+    return d->writeNumericBlock(row, column, values, int(n), 1, format);
+}
+
+/*!
+  Write a block of \a rows x \a columns numbers, given row by row in
+  \a values, starting at (\a row, \a column). Returns true on success.
+ */
+bool Worksheet::writeRange(int row,
+                           int column,
+                           const double *values,
+                           int rows,
+                           int columns,
+                           const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumericBlock(row, column, values, rows, columns, format);
+}
+
+/*!
+  \overload
+ */
+bool Worksheet::writeRange(int row,
+                           int column,
+                           const float *values,
+                           int rows,
+                           int columns,
+                           const Format &format)
+{
+    Q_D(Worksheet);
+    return d->writeNumericBlock(row, column, values, rows, columns, format);
+}
+
 /*!
         \overload
         Write \a formula to the cell \a row_column with the \a format and \a result.
@@ -783,7 +1194,7 @@ bool Worksheet::writeFormula(int row,
         for (int r = range.firstRow(); r <= range.lastRow(); ++r) {
             for (int c = range.firstColumn(); c <= range.lastColumn(); ++c) {
                 if (!(r == row && c == column)) {
-                    if (auto cell = cellAt(r, c)) {
+                    if (auto cell = d->cellTable.editableCellAt(r, c)) {
                         cell->d_ptr->formula = sf;
                     } else {
                         auto newCell = std::make_shared<Cell>(result, Cell::NumberType, fmt, this);
@@ -1043,6 +1454,83 @@ bool Worksheet::writeHyperlink(int row,
     return true;
 }
 
+/*!
+ * Stream \a rowCount rows of \a columnCount numeric cells starting at
+ * (\a firstRow, \a firstColumn). \a source is called once per row while the
+ * sheet is saved and fills \a columnCount values; they are written straight
+ * into the sheet part, so no cells are created and memory does not grow with
+ * the row count. Cells of the cell table inside the block are overridden.
+ * Replaces any previous streamed block. Returns true on success.
+ */
+bool Worksheet::setStreamedRows(int firstRow,
+                                int firstColumn,
+                                int rowCount,
+                                int columnCount,
+                                const RowSource &source,
+                                const Format &format)
+{
+    Q_D(Worksheet);
+    if (rowCount <= 0 || columnCount <= 0 || !source)
+        return false;
+    if (d->checkDimensions(firstRow, firstColumn) ||
+        d->checkDimensions(firstRow + rowCount - 1, firstColumn + columnCount - 1))
+        return false;
+
+    if (format.isValid())
+        d->workbook->styles()->addXfFormat(format);
+
+    d->streamedRows             = StreamedRows();
+    d->streamedRows.firstRow    = firstRow;
+    d->streamedRows.firstColumn = firstColumn;
+    d->streamedRows.rowCount    = rowCount;
+    d->streamedRows.columnCount = columnCount;
+    d->streamedRows.format      = format;
+    d->streamedRows.source      = source;
+    return true;
+}
+
+/*!
+ * Stream float \a columns starting at (\a firstRow, \a firstColumn), see
+ * setStreamedRows(). The sheet takes ownership of the data; values are
+ * written with the shortest representation that round-trips as float.
+ */
+bool Worksheet::setStreamedColumns(int firstRow,
+                                   int firstColumn,
+                                   std::vector<std::vector<float>> columns,
+                                   const Format &format)
+{
+    Q_D(Worksheet);
+    size_t rows = 0;
+    for (const auto &column : columns)
+        rows = std::max(rows, column.size());
+    if (rows > size_t(XLSX_ROW_MAX))
+        return false;
+
+    const int columnCount = int(columns.size());
+    auto data = std::make_shared<std::vector<std::vector<float>>>(std::move(columns));
+    RowSource source = [data, firstRow, columnCount](int row, double *values) {
+        const size_t i = size_t(row - firstRow);
+        for (int c = 0; c < columnCount; ++c) {
+            const std::vector<float> &column = (*data)[c];
+            values[c] = i < column.size() ? double(column[i]) : std::nan("");
+        }
+    };
+
+    if (!setStreamedRows(firstRow, firstColumn, int(rows), columnCount, source, format))
+        return false;
+    d->streamedRows.singlePrecision = true;
+    return true;
+}
+
+/*!
+ * Drop the streamed block. The sheet dimension is not reduced.
+ */
+void Worksheet::clearStreamedRows()
+{
+    Q_D(Worksheet);
+    d->streamedRows = StreamedRows();
+}
+
 /*!
  * Add one DataValidation \a validation to the sheet.
  * Returns true on success.
@@ -1112,6 +1600,47 @@ int Worksheet::insertImage(int row, int column, const QImage &image)
     return imageIndex;
 }
 
+/*!
+ * \overload
+ * Insert an image that is already encoded, \a data in the format named by
+ * \a suffix, at the position \a row, \a column. The bytes are stored as
+ * they are, without being decoded or encoded again. \a size is the display
+ * size in pixels at 96 dpi; if it is not valid, the pixel size is read from
+ * the image header.
+ */
+int Worksheet::insertImage(int row,
+                           int column,
+                           const QByteArray &data,
+                           const QSize &size,
+                           const QString &suffix)
+{
+    Q_D(Worksheet);
+
+    QSize pixels = size;
+    if (!pixels.isValid()) {
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        pixels = QImageReader(&buffer, suffix.toLatin1()).size();
+    }
+    if (data.isEmpty() || !pixels.isValid())
+        return 0;
+
+    if (!d->drawing) {
+        d->drawing = std::make_shared<Drawing>(this, F_NewFromScratch);
+    }
+
+    auto anchor = new DrawingOneCellAnchor(d->drawing.get(), DrawingAnchor::Picture);
+
+    // 9525 EMUs per pixel at 96 dpi
+    anchor->from = XlsxMarker(row, column, 0, 0);
+    anchor->ext  = QSize(pixels.width() * 9525, pixels.height() * 9525);
+
+    anchor->setObjectPicture(data, suffix);
+
+    return anchor->getm_id();
+}
+
 bool Worksheet::getImage(int imageIndex, QImage &img)
 {
     Q_D(Worksheet);
@@ -1222,7 +1751,7 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
     for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
         for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
             if (row == range.firstRow() && col == range.firstColumn()) {
-                auto cell = cellAt(row, col);
+                auto cell = d->cellTable.editableCellAt(row, col);
                 if (cell) {
                     if (format.isValid())
                         cell->d_ptr->format = format;
@@ -1279,7 +1808,14 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
     Q_D(const Worksheet);
     d->relationships->clear();
 
-    QXmlStreamWriter writer(device);
+    // Everything but the rows goes through the writer into a local buffer,
+    // with an empty <sheetData/>. The rows, the bulk of a large sheet, are
+    // formatted by saveXmlSheetData() and written to the device between the
+    // two halves of that buffer; both are plain QIODevice writes.
+    QByteArray xml;
+    QBuffer buffer(&xml);
+    buffer.open(QIODevice::WriteOnly);
+    QXmlStreamWriter writer(&buffer);
 
     writer.writeStartDocument(QStringLiteral("1.0"), true);
     writer.writeStartElement(QStringLiteral("worksheet"));
@@ -1369,10 +1905,7 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
         writer.writeEndElement(); // cols
     }
 
-    writer.writeStartElement(QStringLiteral("sheetData"));
-    if (d->dimension.isValid())
-        d->saveXmlSheetData(writer);
-    writer.writeEndElement(); // sheetData
+    writer.writeEmptyElement(QStringLiteral("sheetData"));
 
     d->saveXmlMergeCells(writer);
     for (const ConditionalFormatting &cf : d->conditionalFormattingList)
@@ -1468,6 +2001,22 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 
     writer.writeEndElement(); // worksheet
     writer.writeEndDocument();
+    buffer.close();
+
+    // Escaped text and attributes cannot contain "<sheetData", so the first
+    // match is the element
+    const qsizetype start = xml.indexOf("<sheetData");
+    const qsizetype end   = start < 0 ? -1 : xml.indexOf('>', start) + 1;
+    Q_ASSERT(end > 0);
+    if (end <= 0 || !d->dimension.isValid()) {
+        device->write(xml);
+        return;
+    }
+    device->write(xml.constData(), start);
+    device->write("<sheetData>");
+    d->saveXmlSheetData(device);
+    device->write("</sheetData>");
+    device->write(xml.constData() + end, xml.size() - end);
 }
 
 //{{ liufeijin
@@ -1481,69 +2030,235 @@ bool Worksheet::setStartPage(int spagen)
 }
 //}}
 
-void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
-{
-    calculateSpans();
-
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        auto ctIt = cellTable.cells.constFind(row_num);
-        auto riIt = rowsInfo.constFind(row_num);
-        if (ctIt == cellTable.cells.constEnd() && riIt == rowsInfo.constEnd() &&
-            !comments.contains(row_num)) {
-            // Only process rows with cell data / comments / formatting
-            continue;
+/*
+  Writes the <row>/<c> elements as UTF-8 to the device, in chunks of about
+  SheetDataFlushSize bytes.
+  Only occupied rows and cells are visited, in sorted order, and references
+  and numbers are formatted into a reusable byte buffer. Numbers, shared
+  strings, booleans, blanks, dense columns and streamed rows take this
+  path; anything else (inline and rich strings, formulas, dates, errors)
+  is serialized by saveXmlCellData() through a scratch writer.
+
+  The "spans" attribute (min:max column of each block of 16 rows) is an
+  optional hint that Excel writes too; it is computed per block just before
+  the block is written.
+ */
+void WorksheetPrivate::saveXmlSheetData(QIODevice *device) const
+{
+    // Rows with cells, formatting or comments, ascending; the streamed
+    // interval is merged in while writing
+    QList<int> rows = cellTable.sortedRows();
+    rows.append(rowsInfo.keys());
+    rows.append(comments.keys());
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    rows.erase(std::remove_if(rows.begin(),
+                              rows.end(),
+                              [this](int r) {
+                                  return r < dimension.firstRow() || r > dimension.lastRow();
+                              }),
+               rows.end());
+
+    std::string out;
+    out.reserve(SheetDataFlushSize + 4096);
+    std::vector<double> streamed(streamedRows.isEmpty() ? 0 : streamedRows.columnCount);
+    std::vector<int> columns;
+    std::vector<int> columnStyles; // xf index per column, -1 none, -2 not looked up yet
+
+    QBuffer scratch;
+    scratch.open(QIODevice::WriteOnly);
+    QXmlStreamWriter scratchWriter(&scratch);
+
+    auto columnStyle = [&](int col) {
+        if (col >= int(columnStyles.size()))
+            columnStyles.resize(col + 1, -2);
+        int &style = columnStyles[col];
+        if (style == -2) {
+            auto cIt = colsInfoHelper.constFind(col);
+            style    = cIt != colsInfoHelper.constEnd() && !(*cIt)->format.isEmpty()
+                           ? (*cIt)->format.xfIndex()
+                           : -1;
         }
+        return style;
+    };
 
-        int span_index = (row_num - 1) / 16;
-        QString span;
-        auto rsIt = row_spans.constFind(span_index);
-        if (rsIt != row_spans.constEnd())
-            span = rsIt.value();
+    // Style used by the cell, row or col
+    auto appendCellStart = [&](int row, int col, const Format &format, int rowStyle) {
+        out += "<c r=\"";
+        appendCellReference(out, row, col);
+        out += '"';
+        const int style =
+            !format.isEmpty() ? format.xfIndex() : (rowStyle >= 0 ? rowStyle : columnStyle(col));
+        if (style >= 0) {
+            out += " s=\"";
+            appendInt(out, style);
+            out += '"';
+        }
+    };
+
+    auto appendStreamedCell = [&](int row, int col, double value, int rowStyle) {
+        if (!std::isfinite(value))
+            return;
+        appendCellStart(row, col, streamedRows.format, rowStyle);
+        out += "><v>";
+        appendNumber(out, value, streamedRows.singlePrecision);
+        out += "</v></c>";
+    };
+
+    auto appendCell = [&](int row, int col, const std::shared_ptr<Cell> &cell, int rowStyle) {
+        const Cell::CellType type = cell->cellType();
+        const bool fast           = !cell->hasFormula() &&
+                          (type == Cell::NumberType || type == Cell::SharedStringType ||
+                           type == Cell::BooleanType);
+        if (!fast) {
+            scratch.buffer().clear();
+            scratch.seek(0);
+            saveXmlCellData(scratchWriter, row, col, cell);
+            out.append(scratch.buffer().constData(), size_t(scratch.buffer().size()));
+            return;
+        }
 
-        writer.writeStartElement(QStringLiteral("row"));
-        writer.writeAttribute(QStringLiteral("r"), QString::number(row_num));
+        appendCellStart(row, col, cell->format(), rowStyle);
+        const QVariant value = cell->value();
+        if (type == Cell::SharedStringType) {
+            const int sst_idx = cell->isRichString()
+                                    ? sharedStrings()->getSharedStringIndex(cell->d_ptr->richString)
+                                    : sharedStrings()->getSharedStringIndex(value.toString());
+            out += " t=\"s\"><v>";
+            appendInt(out, sst_idx);
+            out += "</v></c>";
+        } else if (type == Cell::BooleanType) {
+            out += value.toBool() ? " t=\"b\"><v>1</v></c>" : " t=\"b\"><v>0</v></c>";
+        } else if (value.isValid() && std::isfinite(value.toDouble())) {
+            out += "><v>";
+            appendNumber(out, value.toDouble(), value.userType() == QMetaType::Float);
+            out += "</v></c>";
+        } else {
+            out += "/>"; // invalid value means 'v' is blank
+        }
+    };
+
+    int ri           = 0;
+    int nextStreamed = streamedRows.isEmpty() ? INT_MAX : streamedRows.firstRow;
+    auto nextRow     = [&]() { return std::min(ri < rows.size() ? rows[ri] : INT_MAX, nextStreamed); };
+
+    for (int row_num = nextRow(); row_num != INT_MAX; row_num = nextRow()) {
+        // Span of the block of 16 rows this row starts writing
+        const int blockLast = ((row_num - 1) / 16 + 1) * 16;
+        int span_min        = INT_MAX;
+        int span_max        = -1;
+        for (int k = ri; k < rows.size() && rows[k] <= blockLast; ++k) {
+            cellTable.sortedColumns(rows[k], columns);
+            if (!columns.empty()) {
+                span_min = qMin(span_min, columns.front());
+                span_max = qMax(span_max, columns.back());
+            }
+            auto cIt = comments.constFind(rows[k]);
+            if (cIt != comments.constEnd()) {
+                for (auto it = cIt->keyBegin(); it != cIt->keyEnd(); ++it) {
+                    span_min = qMin(span_min, *it);
+                    span_max = qMax(span_max, *it);
+                }
+            }
+        }
+        if (nextStreamed <= blockLast) {
+            span_min = qMin(span_min, streamedRows.firstColumn);
+            span_max = qMax(span_max, streamedRows.lastColumn());
+        }
 
-        if (!span.isEmpty())
-            writer.writeAttribute(QStringLiteral("spans"), span);
+        for (; row_num <= blockLast; row_num = nextRow()) {
+            const bool isExplicit = ri < rows.size() && rows[ri] == row_num;
+            const bool isStreamed = row_num == nextStreamed;
 
-        if (riIt != rowsInfo.constEnd()) {
-            std::shared_ptr<XlsxRowInfo> rowInfo = riIt.value();
-            if (!rowInfo->format.isEmpty()) {
-                writer.writeAttribute(QStringLiteral("s"),
-                                      QString::number(rowInfo->format.xfIndex()));
-                writer.writeAttribute(QStringLiteral("customFormat"), QStringLiteral("1"));
+            out += "<row r=\"";
+            appendInt(out, row_num);
+            out += '"';
+            if (span_max != -1) {
+                out += " spans=\"";
+                appendInt(out, span_min);
+                out += ':';
+                appendInt(out, span_max);
+                out += '"';
             }
 
-            //! Todo: support customHeight from info struct
-            //! Todo: where does this magic number '15' come from?
-            if (rowInfo->customHeight) {
-                writer.writeAttribute(QStringLiteral("ht"), QString::number(rowInfo->height));
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("1"));
-            } else {
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("0"));
-            }
+            int rowStyle = -1;
+            auto riIt    = rowsInfo.constFind(row_num);
+            if (riIt != rowsInfo.constEnd()) {
+                std::shared_ptr<XlsxRowInfo> rowInfo = riIt.value();
+                if (!rowInfo->format.isEmpty()) {
+                    rowStyle = rowInfo->format.xfIndex();
+                    out += " s=\"";
+                    appendInt(out, rowStyle);
+                    out += "\" customFormat=\"1\"";
+                }
 
-            if (rowInfo->hidden)
-                writer.writeAttribute(QStringLiteral("hidden"), QStringLiteral("1"));
-            if (rowInfo->outlineLevel > 0)
-                writer.writeAttribute(QStringLiteral("outlineLevel"),
-                                      QString::number(rowInfo->outlineLevel));
-            if (rowInfo->collapsed)
-                writer.writeAttribute(QStringLiteral("collapsed"), QStringLiteral("1"));
-        }
+                //! Todo: support customHeight from info struct
+                if (rowInfo->customHeight) {
+                    out += " ht=\"";
+                    out += QString::number(rowInfo->height).toStdString();
+                    out += "\" customHeight=\"1\"";
+                } else {
+                    out += " customHeight=\"0\"";
+                }
 
-        // Write cell data if row contains filled cells
-        if (ctIt != cellTable.cells.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                auto cellIt = ctIt->find(col_num);
-                if (cellIt != ctIt->end()) {
-                    saveXmlCellData(writer, row_num, col_num, *cellIt);
+                if (rowInfo->hidden)
+                    out += " hidden=\"1\"";
+                if (rowInfo->outlineLevel > 0) {
+                    out += " outlineLevel=\"";
+                    appendInt(out, rowInfo->outlineLevel);
+                    out += '"';
                 }
+                if (rowInfo->collapsed)
+                    out += " collapsed=\"1\"";
             }
+            out += '>';
+
+            // Cells in column order; streamed columns override the cell table
+            cellTable.sortedColumns(row_num, columns);
+            auto ctIt = cellTable.cells.constFind(row_num);
+            auto appendTableCell = [&](int col) {
+                if (ctIt != cellTable.cells.constEnd()) {
+                    auto it = ctIt->constFind(col);
+                    if (it != ctIt->constEnd()) {
+                        appendCell(row_num, col, *it, rowStyle);
+                        return;
+                    }
+                }
+                const DenseColumn *dc = cellTable.denseColumn(col);
+                appendCellStart(row_num, col, Format(), rowStyle);
+                out += "><v>";
+                appendNumber(out, dc->at(row_num), dc->allFloat);
+                out += "</v></c>";
+            };
+
+            size_t ci = 0;
+            if (isStreamed) {
+                streamedRows.source(row_num, streamed.data());
+                for (; ci < columns.size() && columns[ci] < streamedRows.firstColumn; ++ci)
+                    appendTableCell(columns[ci]);
+                for (int c = streamedRows.firstColumn; c <= streamedRows.lastColumn(); ++c)
+                    appendStreamedCell(
+                        row_num, c, streamed[c - streamedRows.firstColumn], rowStyle);
+                while (ci < columns.size() && columns[ci] <= streamedRows.lastColumn())
+                    ++ci;
+            }
+            for (; ci < columns.size(); ++ci)
+                appendTableCell(columns[ci]);
+
+            out += "</row>";
+            if (out.size() >= SheetDataFlushSize) {
+                device->write(out.data(), qint64(out.size()));
+                out.clear();
+            }
+
+            if (isExplicit)
+                ++ri;
+            if (isStreamed)
+                nextStreamed = row_num < streamedRows.lastRow() ? row_num + 1 : INT_MAX;
         }
-        writer.writeEndElement(); // row
     }
+
+    device->write(out.data(), qint64(out.size()));
 }
 
 void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer,
@@ -2848,13 +3563,16 @@ QVector<CellLocation> Worksheet::getFullCells(int *maxRow, int *maxCol) const
     }
 
     const auto sortedRows = d->cellTable.sortedRows();
+    std::vector<int> columnsSorted;
     for (const auto row : sortedRows) {
-        const auto &columns      = d->cellTable.cells[row];
-        const auto columnsSorted = CellTable::sorteIntList(columns.keys());
+        const auto &columns = d->cellTable.cells[row];
+        d->cellTable.sortedColumns(row, columnsSorted);
         for (const auto &col : columnsSorted) {
             // It's faster to iterate but cellTable is unordered which might not
             // be what callers want?
-            auto cell = std::make_shared<Cell>(columns.value(col).get());
+            auto it   = columns.constFind(col);
+            auto cell = it != columns.constEnd() ? std::make_shared<Cell>(it->get())
+                                                 : d->cellTable.cellAt(row, col);
 
             CellLocation cl;
 
@@ -2,47 +2,423 @@
 
 #include "xlsxzipwriter_p.h"
 
-#include <private/qzipwriter_p.h>
+#include <QDateTime>
+#include <QFile>
+#include <QVector>
 
-#include <QDebug>
+#include <functional>
+
+#include <zlib.h>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+namespace {
+
+const quint32 LocalHeaderSignature     = 0x04034b50;
+const quint32 DataDescriptorSignature  = 0x08074b50;
+const quint32 CentralHeaderSignature   = 0x02014b50;
+const quint32 EndOfCentralDirSignature = 0x06054b50;
+
+const quint16 ZipVersion         = 20;
+const quint16 FlagDataDescriptor = 0x0008; // sizes and crc follow the data
+const quint16 FlagUtf8Name       = 0x0800;
+const quint16 MethodStored       = 0;
+const quint16 MethodDeflated     = 8;
+
+const int StreamChunkSize = 64 * 1024;
+
+// Without Zip64, sizes and offsets are 32-bit (0xffffffff marks a Zip64
+// value) and the entry count is 16-bit. Anything beyond fails the archive
+// instead of wrapping around.
+const quint64 MaxZip32Size  = 0xfffffffe;
+const qsizetype MaxEntries  = 0xffff;
+
+void put16(QByteArray &out, quint16 v)
+{
+    const char b[2] = {char(v & 0xff), char(v >> 8)};
+    out.append(b, 2);
+}
+
+void put32(QByteArray &out, quint32 v)
+{
+    put16(out, quint16(v & 0xffff));
+    put16(out, quint16(v >> 16));
+}
+
+struct ZipEntry {
+    QByteArray name;
+    quint16 flags            = FlagUtf8Name;
+    quint16 method           = MethodStored;
+    quint32 crc              = 0;
+    quint32 compressedSize   = 0;
+    quint32 uncompressedSize = 0;
+    quint32 offset           = 0;
+};
+
+} // namespace
+
+class ZipEntryDevice;
+
+class ZipWriterPrivate
+{
+public:
+    QIODevice *device = nullptr;
+    QFile *ownedFile  = nullptr;
+    bool failed       = false;
+    bool closed       = false;
+    quint64 offset    = 0; // bytes written so far
+    quint16 dosTime   = 0;
+    quint16 dosDate   = 0;
+    QVector<ZipEntry> entries;
+    ZipEntryDevice *stream = nullptr;
+
+    void init(QIODevice *dev);
+    void write(const char *data, qint64 len);
+    void write(const QByteArray &bytes) { write(bytes.constData(), bytes.size()); }
+    void writeLocalHeader(const ZipEntry &entry);
+    void writeCentralDirectory();
+};
+
+// Deflates everything written to it into the sink, the archive of a
+// streamed entry
+class ZipEntryDevice : public QIODevice
+{
+public:
+    using Sink = std::function<bool(const char *data, qint64 len)>;
+
+    ZipEntryDevice(const Sink &sink, int level)
+        : m_sink(sink)
+    {
+        m_stream.zalloc = Z_NULL;
+        m_stream.zfree  = Z_NULL;
+        m_stream.opaque = Z_NULL;
+        // raw deflate data, no zlib header
+        m_ok = deflateInit2(&m_stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) ==
+               Z_OK;
+        m_pending.reserve(StreamChunkSize);
+        m_out.resize(StreamChunkSize);
+        open(QIODevice::WriteOnly);
+    }
+
+    ~ZipEntryDevice() override { deflateEnd(&m_stream); }
+
+    bool finish()
+    {
+        m_ok = m_ok && deflateChunk(Z_FINISH);
+        QIODevice::close();
+        return m_ok;
+    }
+
+    quint32 crc() const { return m_crc; }
+    // Both fit in 32 bits while finish() succeeds
+    quint32 compressedSize() const { return quint32(m_compressed); }
+    quint32 uncompressedSize() const { return quint32(m_uncompressed); }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        if (!m_ok)
+            return -1;
+        if (quint64(len) > MaxZip32Size - m_uncompressed) {
+            m_ok = false;
+            return -1;
+        }
+        m_crc = crc32(m_crc, reinterpret_cast<const Bytef *>(data), uInt(len));
+        m_uncompressed += quint64(len);
+        m_pending.append(data, len);
+        if (m_pending.size() >= StreamChunkSize)
+            m_ok = deflateChunk(Z_NO_FLUSH);
+        return m_ok ? len : -1;
+    }
+
+private:
+    bool deflateChunk(int flush)
+    {
+        m_stream.next_in  = reinterpret_cast<Bytef *>(m_pending.data());
+        m_stream.avail_in = uInt(m_pending.size());
+        int ret;
+        do {
+            m_stream.next_out  = reinterpret_cast<Bytef *>(m_out.data());
+            m_stream.avail_out = uInt(m_out.size());
+            ret                = deflate(&m_stream, flush);
+            if (ret == Z_STREAM_ERROR)
+                return false;
+            const qint64 have = m_out.size() - m_stream.avail_out;
+            if (quint64(have) > MaxZip32Size - m_compressed || !m_sink(m_out.constData(), have))
+                return false;
+            m_compressed += quint64(have);
+        } while (m_stream.avail_out == 0);
+        m_pending.clear();
+        return flush != Z_FINISH || ret == Z_STREAM_END;
+    }
+
+    Sink m_sink;
+    z_stream m_stream;
+    bool m_ok;
+    quint32 m_crc          = 0;
+    quint64 m_compressed   = 0;
+    quint64 m_uncompressed = 0;
+    QByteArray m_pending;
+    QByteArray m_out;
+};
+
+void ZipWriterPrivate::init(QIODevice *dev)
+{
+    device = dev;
+    if (!device->isOpen() && !device->open(QIODevice::WriteOnly))
+        failed = true;
+    else if (!device->isWritable())
+        failed = true;
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate date    = now.date();
+    const QTime time    = now.time();
+    dosTime = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    dosDate = quint16(((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day());
+}
+
+void ZipWriterPrivate::write(const char *data, qint64 len)
+{
+    if (failed || len <= 0)
+        return;
+    if (quint64(len) > MaxZip32Size - offset || device->write(data, len) != len) {
+        failed = true;
+        return;
+    }
+    offset += quint64(len);
+}
+
+void ZipWriterPrivate::writeLocalHeader(const ZipEntry &entry)
+{
+    if (entry.name.size() > 0xffff) {
+        failed = true;
+        return;
+    }
+    QByteArray header;
+    header.reserve(30 + entry.name.size());
+    put32(header, LocalHeaderSignature);
+    put16(header, ZipVersion);
+    put16(header, entry.flags);
+    put16(header, entry.method);
+    put16(header, dosTime);
+    put16(header, dosDate);
+    put32(header, entry.crc); // zero for streamed entries, see data descriptor
+    put32(header, entry.compressedSize);
+    put32(header, entry.uncompressedSize);
+    put16(header, quint16(entry.name.size()));
+    put16(header, 0); // extra field length
+    header.append(entry.name);
+    write(header);
+}
+
+void ZipWriterPrivate::writeCentralDirectory()
+{
+    if (entries.size() > MaxEntries) {
+        failed = true;
+        return;
+    }
+    const quint64 start = offset;
+    QByteArray dir;
+    for (const ZipEntry &entry : entries) {
+        put32(dir, CentralHeaderSignature);
+        put16(dir, ZipVersion); // version made by
+        put16(dir, ZipVersion); // version needed
+        put16(dir, entry.flags);
+        put16(dir, entry.method);
+        put16(dir, dosTime);
+        put16(dir, dosDate);
+        put32(dir, entry.crc);
+        put32(dir, entry.compressedSize);
+        put32(dir, entry.uncompressedSize);
+        put16(dir, quint16(entry.name.size()));
+        put16(dir, 0); // extra field length
+        put16(dir, 0); // comment length
+        put16(dir, 0); // disk number
+        put16(dir, 0); // internal attributes
+        put32(dir, 0); // external attributes
+        put32(dir, entry.offset);
+        dir.append(entry.name);
+    }
+    write(dir);
+
+    QByteArray end;
+    put32(end, EndOfCentralDirSignature);
+    put16(end, 0); // this disk
+    put16(end, 0); // disk with the central directory
+    put16(end, quint16(entries.size()));
+    put16(end, quint16(entries.size()));
+    put32(end, quint32(dir.size()));
+    put32(end, quint32(start));
+    put16(end, 0); // comment length
+    write(end);
+}
+
 ZipWriter::ZipWriter(const QString &filePath)
+    : d(new ZipWriterPrivate)
 {
-    m_writer = new QZipWriter(filePath, QIODevice::WriteOnly);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    d->ownedFile = new QFile(filePath);
+    d->init(d->ownedFile);
 }
 
 ZipWriter::ZipWriter(QIODevice *device)
+    : d(new ZipWriterPrivate)
 {
-    m_writer = new QZipWriter(device);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    d->init(device);
 }
 
 ZipWriter::~ZipWriter()
 {
-    delete m_writer;
+    close();
+    delete d->ownedFile;
+    delete d;
 }
 
 bool ZipWriter::error() const
 {
-    return m_writer->status() != QZipWriter::NoError;
+    return d->failed;
+}
+
+void ZipWriter::addFile(const QString &filePath, QIODevice *device, int level)
+{
+    const bool opened = !device->isOpen();
+    if (opened && !device->open(QIODevice::ReadOnly)) {
+        d->failed = true;
+        return;
+    }
+    addFile(filePath, device->readAll(), level);
+    if (opened)
+        device->close();
 }
 
-void ZipWriter::addFile(const QString &filePath, QIODevice *device)
+void ZipWriter::addFile(const QString &filePath, const QByteArray &data, int level)
 {
-    m_writer->addFile(filePath, device);
+    addEntry(compress(filePath, data, level));
 }
 
-void ZipWriter::addFile(const QString &filePath, const QByteArray &data)
+ZipWriter::Entry ZipWriter::compress(const QString &filePath, const QByteArray &data, int level)
 {
-    m_writer->addFile(filePath, data);
+    Entry entry;
+    entry.path = filePath;
+    if (quint64(data.size()) > MaxZip32Size) {
+        entry.failed = true;
+        return entry;
+    }
+    entry.uncompressedSize = quint32(data.size());
+    entry.crc = crc32(0, reinterpret_cast<const Bytef *>(data.constData()), uInt(data.size()));
+
+    // Deflate unless that does not make the entry smaller
+    QByteArray packed;
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree  = Z_NULL;
+    zs.opaque = Z_NULL;
+    if (!data.isEmpty() && level != 0 &&
+        deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        packed.resize(int(deflateBound(&zs, uLong(data.size()))));
+        zs.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+        zs.avail_in  = uInt(data.size());
+        zs.next_out  = reinterpret_cast<Bytef *>(packed.data());
+        zs.avail_out = uInt(packed.size());
+        if (deflate(&zs, Z_FINISH) == Z_STREAM_END)
+            packed.resize(int(zs.total_out));
+        else
+            packed.clear();
+        deflateEnd(&zs);
+    }
+
+    entry.deflated = !packed.isEmpty() && packed.size() < data.size();
+    entry.data     = entry.deflated ? packed : data;
+    return entry;
+}
+
+void ZipWriter::addEntry(const Entry &entry)
+{
+    Q_ASSERT_X(!d->stream, "ZipWriter::addEntry", "a streamed entry is still open");
+    if (d->failed || d->closed)
+        return;
+    if (entry.failed) {
+        d->failed = true;
+        return;
+    }
+
+    if (quint64(entry.data.size()) > MaxZip32Size) {
+        d->failed = true;
+        return;
+    }
+
+    ZipEntry zipEntry;
+    zipEntry.name             = entry.path.toUtf8();
+    zipEntry.offset           = quint32(d->offset); // write() keeps offset within 32 bits
+    zipEntry.method           = entry.deflated ? MethodDeflated : MethodStored;
+    zipEntry.crc              = entry.crc;
+    zipEntry.compressedSize   = quint32(entry.data.size());
+    zipEntry.uncompressedSize = entry.uncompressedSize;
+
+    d->writeLocalHeader(zipEntry);
+    d->write(entry.data);
+    d->entries.append(zipEntry);
+}
+
+QIODevice *ZipWriter::beginFile(const QString &filePath, int level)
+{
+    Q_ASSERT_X(!d->stream, "ZipWriter::beginFile", "a streamed entry is still open");
+    if (d->stream)
+        endFile();
+
+    ZipEntry entry;
+    entry.name   = filePath.toUtf8();
+    entry.flags  = FlagUtf8Name | FlagDataDescriptor;
+    entry.method = MethodDeflated;
+    entry.offset = quint32(d->offset);
+    d->writeLocalHeader(entry);
+    d->entries.append(entry);
+
+    // The size is not known up front, so even level 0 goes through deflate
+    // (as stored blocks): a stored entry with a data descriptor is not
+    // readable by every unzipper.
+    ZipWriterPrivate *zip = d;
+    d->stream             = new ZipEntryDevice(
+        [zip](const char *data, qint64 len) {
+            zip->write(data, len);
+            return !zip->failed;
+        },
+        level);
+    return d->stream;
+}
+
+void ZipWriter::endFile()
+{
+    if (!d->stream)
+        return;
+
+    ZipEntry &entry = d->entries.last();
+    if (!d->stream->finish())
+        d->failed = true;
+    entry.crc              = d->stream->crc();
+    entry.compressedSize   = d->stream->compressedSize();
+    entry.uncompressedSize = d->stream->uncompressedSize();
+    delete d->stream;
+    d->stream = nullptr;
+
+    QByteArray descriptor;
+    put32(descriptor, DataDescriptorSignature);
+    put32(descriptor, entry.crc);
+    put32(descriptor, entry.compressedSize);
+    put32(descriptor, entry.uncompressedSize);
+    d->write(descriptor);
 }
 
 void ZipWriter::close()
 {
-    m_writer->close();
+    if (d->closed)
+        return;
+    endFile();
+    d->writeCentralDirectory();
+    d->closed = true;
+    if (d->ownedFile)
+        d->ownedFile->close();
 }
 
 QT_END_NAMESPACE_XLSX
@@ -0,0 +1,20 @@
+# Sweep analysis and recording code without GUI dependencies, shared by
+# LossFactorAnalyzer.pro and LossFactorBatch.pro
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+
+SOURCES += \
+    $$PWD/lorentzian_kernels.cpp \
+    $$PWD/recordingview.cpp \
+    $$PWD/resonanceanalyzer.cpp \
+    $$PWD/sweepanalysis.cpp
+
+HEADERS += \
+    $$PWD/appendonlystore.h \
+    $$PWD/lorentzian_kernels.h \
+    $$PWD/recordingformat.h \
+    $$PWD/recordingview.h \
+    $$PWD/resonanceanalyzer.h \
+    $$PWD/samplerecord.h \
+    $$PWD/skewed_lorentzian_fit.hpp \
+    $$PWD/sweepanalysis.h
@@ -0,0 +1,82 @@
+#include "analysisworker.h"
+#include <QElapsedTimer>
+
+AnalysisWorker::AnalysisWorker(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<AnalysisResult>();
+    m_clock.start();
+}
+
+void AnalysisWorker::submit(const FrameSnapshot &frames, float fmin, float fmax, bool useFit) {
+    QMutexLocker lock(&m_mutex);
+    if (m_hasJob) {
+        ++m_dropped;
+        m_droppedMetric.add();
+    }
+    m_pending = {frames, fmin, fmax, useFit, m_clock.nsecsElapsed()};
+    m_hasJob = true;
+
+    if (!m_scheduled) {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &AnalysisWorker::process, Qt::QueuedConnection);
+    }
+}
+
+quint64 AnalysisWorker::droppedJobs() const {
+    QMutexLocker lock(&m_mutex);
+    return m_dropped;
+}
+
+void AnalysisWorker::process() {
+    Job job;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_hasJob) {
+            m_scheduled = false;
+            return;
+        }
+        job = std::move(m_pending);
+        m_pending = Job();
+        m_hasJob = false;
+        m_scheduled = false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (job.fmin != m_fmin || job.fmax != m_fmax) {
+        m_analyzer.setFrequencyRange(job.fmin, job.fmax);
+        m_fmin = job.fmin;
+        m_fmax = job.fmax;
+    }
+    m_analyzer.update(job.frames);
+
+    AnalysisResult result;
+    result.generation = job.frames.generation();
+    result.frames = job.frames.size();
+    result.fmin = job.fmin;
+    result.fmax = job.fmax;
+    result.usedFit = job.useFit;
+
+    if (m_analyzer.x().size() >= 3) {
+        if (job.useFit) {
+            bool fitted;
+            {
+                ScopedTimer fitTimer(m_fitMetric);
+                fitted = m_analyzer.fit(result.fitX, result.fitY);
+            }
+            if (fitted) {
+                halfPowerBandwidth(result.fitX, result.fitY, result.hp);
+                result.fitParams = m_analyzer.fitParams();
+                result.fitStats = m_analyzer.fitStats();
+            }
+        } else {
+            result.hp = m_analyzer.halfPower();
+        }
+    }
+
+    const qint64 ns = timer.nsecsElapsed();
+    result.durationMs = ns / 1e6;
+    m_passMetric.record(ns);
+    m_latencyMetric.record(m_clock.nsecsElapsed() - job.submittedNs);
+    emit resultReady(result);
+}
@@ -0,0 +1,76 @@
+#ifndef ANALYSISWORKER_H
+#define ANALYSISWORKER_H
+
+#pragma once
+
+#include <QObject>
+#include <QMutex>
+#include <QMetaType>
+#include <QElapsedTimer>
+#include <vector>
+#include "resonanceanalyzer.h"
+#include "metrics.h"
+
+// Outcome of one analysis pass, applied by the GUI as-is
+struct AnalysisResult {
+    quint64 generation = 0;     // FrameSnapshot::generation() analysed
+    std::size_t frames = 0;     // snapshot size analysed
+    float fmin = 0, fmax = 0;
+    bool usedFit = false;
+
+    HalfPowerResult hp;         // peak, f1, f2, loss factor
+    std::vector<float> fitX, fitY;
+    LorentzianParams fitParams;
+    FitStats fitStats;
+    double durationMs = 0;
+};
+
+Q_DECLARE_METATYPE(AnalysisResult)
+
+// Runs ResonanceAnalyzer on its own thread. submit() may be called from any
+// thread with an immutable frame snapshot; a job that has not started when a
+// newer one arrives is dropped (the analysis is incremental, so the newest
+// snapshot covers everything the dropped one had).
+class AnalysisWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AnalysisWorker(QObject *parent = nullptr);
+
+    void submit(const FrameSnapshot &frames, float fmin, float fmax, bool useFit);
+
+    quint64 droppedJobs() const;
+
+signals:
+    void resultReady(const AnalysisResult &result);
+
+private:
+    struct Job {
+        FrameSnapshot frames;
+        float fmin = 0, fmax = 0;
+        bool useFit = false;
+        qint64 submittedNs = 0;
+    };
+
+    mutable QMutex m_mutex;
+    Job m_pending;
+    bool m_hasJob = false;
+    bool m_scheduled = false;
+    quint64 m_dropped = 0;
+    QElapsedTimer m_clock;
+
+    // "analysis.pass" is the work of one pass, "analysis.latency" adds the
+    // time the snapshot waited for the worker
+    Histogram &m_passMetric = Metrics::instance().histogram("analysis.pass");
+    Histogram &m_fitMetric = Metrics::instance().histogram("analysis.fit");
+    Histogram &m_latencyMetric = Metrics::instance().histogram("analysis.latency");
+    Counter &m_droppedMetric = Metrics::instance().counter("analysis.dropped_jobs");
+
+    // worker thread only
+    ResonanceAnalyzer m_analyzer;
+    float m_fmin = -1, m_fmax = -1;
+
+    void process();
+};
+
+#endif // ANALYSISWORKER_H
@@ -0,0 +1,111 @@
+#ifndef APPENDONLYSTORE_H
+#define APPENDONLYSTORE_H
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Append-only storage in fixed-size chunks that never move once allocated.
+// snapshot() hands out a read-only view (shared chunk list + element count)
+// without copying any element: readers only touch indices below their
+// snapshot size and the writer only writes above it, so a snapshot may be
+// passed to another thread (through a queued signal or similar) and read
+// there while the owner keeps appending.
+//
+// Allocations happen only when a new chunk starts (the chunk and a new chunk
+// list); taking a snapshot allocates nothing.
+template <typename T, std::size_t ChunkSize = 4096>
+class AppendOnlyStore {
+public:
+    struct Chunk {
+        T items[ChunkSize];
+    };
+    using ChunkList = std::vector<std::shared_ptr<const Chunk>>;
+
+    class Snapshot {
+    public:
+        Snapshot() = default;
+
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        // Changes whenever the store is cleared; cursors from another
+        // generation are meaningless.
+        std::uint64_t generation() const { return m_generation; }
+
+        const T &operator[](std::size_t i) const {
+            return (*m_chunks)[i / ChunkSize]->items[i % ChunkSize];
+        }
+        const T &back() const { return (*this)[m_size - 1]; }
+
+        // fn(const T *data, std::size_t n) for each contiguous run in [from, size())
+        template <typename Fn>
+        void forEachSpan(std::size_t from, Fn &&fn) const {
+            while (from < m_size) {
+                std::size_t offset = from % ChunkSize;
+                std::size_t n = std::min(ChunkSize - offset, m_size - from);
+                fn((*m_chunks)[from / ChunkSize]->items + offset, n);
+                from += n;
+            }
+        }
+
+        // fn(const T &item) for each element in [from, size())
+        template <typename Fn>
+        void forEach(std::size_t from, Fn &&fn) const {
+            forEachSpan(from, [&fn](const T *data, std::size_t n) {
+                for (std::size_t i = 0; i < n; ++i) fn(data[i]);
+            });
+        }
+
+    private:
+        friend class AppendOnlyStore;
+        Snapshot(std::shared_ptr<const ChunkList> chunks, std::size_t size, std::uint64_t generation)
+            : m_chunks(std::move(chunks)), m_size(size), m_generation(generation) {}
+
+        std::shared_ptr<const ChunkList> m_chunks;
+        std::size_t m_size = 0;
+        std::uint64_t m_generation = 0;
+    };
+
+    void push_back(const T &item) {
+        std::size_t offset = m_size % ChunkSize;
+        if (offset == 0) {
+            m_tail = std::make_shared<Chunk>();
+            // copy-on-write: snapshots keep referencing the old list
+            auto list = std::make_shared<ChunkList>();
+            list->reserve((m_chunks ? m_chunks->size() : 0) + 1);
+            if (m_chunks) list->insert(list->end(), m_chunks->begin(), m_chunks->end());
+            list->push_back(m_tail);
+            m_chunks = std::move(list);
+            m_chunkAllocations += 3; // chunk, list, list buffer
+        }
+        m_tail->items[offset] = item;
+        ++m_size;
+    }
+
+    void clear() {
+        m_chunks.reset();
+        m_tail.reset();
+        m_size = 0;
+        ++m_generation;
+    }
+
+    std::size_t size() const { return m_size; }
+
+    Snapshot snapshot() const { return Snapshot(m_chunks, m_size, m_generation); }
+
+    // Heap allocations made by push_back so far (for profiling)
+    std::uint64_t chunkAllocations() const { return m_chunkAllocations; }
+
+private:
+    std::shared_ptr<const ChunkList> m_chunks;
+    std::shared_ptr<Chunk> m_tail;
+    std::size_t m_size = 0;
+    std::uint64_t m_generation = 0;
+    std::uint64_t m_chunkAllocations = 0;
+};
+
+#endif // APPENDONLYSTORE_H
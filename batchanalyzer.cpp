@@ -0,0 +1,191 @@
+// Headless batch analysis of recorded sweeps.
+//
+//   LossFactorBatch [options] <recording or directory>...
+//
+// Every *.lfarec file named, or found in a named directory, is analysed as
+// the GUI analyses a live sweep; files are spread over all cores and one
+// result per file is written as CSV or JSON, sorted by path.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#include "sweepanalysis.h"
+
+namespace {
+
+QString number(double v) {
+    return QString::number(v, 'g', 7);
+}
+
+QString csvField(const QString &s) {
+    if (!s.contains(',') && !s.contains('"') && !s.contains('\n')) return s;
+    return '"' + QString(s).replace('"', "\"\"") + '"';
+}
+
+void writeCsv(QTextStream &out, const QList<SweepAnalysis> &results) {
+    out << "file,status,readings,frames,points,fmin,fmax,"
+           "f0,peak_amplitude,f1,f2,delta_f,loss_factor,"
+           "fit_f0,fit_f1,fit_f2,fit_delta_f,fit_loss_factor,"
+           "fit_A0,fit_f0_param,fit_eta,fit_alpha,fit_offset,fit_iterations,fit_sse,fit_converged,ms\n";
+
+    for (const SweepAnalysis &r : results) {
+        QStringList row;
+        row << csvField(r.path) << csvField(r.ok() ? "ok" : r.error)
+            << QString::number(r.readings) << QString::number(r.frames) << QString::number(r.points)
+            << number(r.fmin) << number(r.fmax);
+
+        const HalfPowerResult &hp = r.hp;
+        if (hp.ok)
+            row << number(hp.peakFreq) << number(hp.peakAmplitude) << number(hp.f1) << number(hp.f2)
+                << number(hp.deltaF) << number(hp.lossFactor);
+        else
+            row << "" << "" << "" << "" << "" << "";
+
+        const HalfPowerResult &fit = r.fitHp;
+        if (r.fitted && fit.ok)
+            row << number(fit.peakFreq) << number(fit.f1) << number(fit.f2) << number(fit.deltaF)
+                << number(fit.lossFactor);
+        else
+            row << "" << "" << "" << "" << "";
+
+        const LorentzianParams &p = r.fitParams;
+        if (r.fitted)
+            row << number(p.A0) << number(p.f0) << number(p.eta) << number(p.alpha) << number(p.offset)
+                << QString::number(r.fitStats.iterations) << number(r.fitStats.sse)
+                << (r.fitStats.converged ? "1" : "0");
+        else
+            row << "" << "" << "" << "" << "" << "" << "" << "";
+
+        row << QString::number(r.durationMs, 'f', 2);
+        out << row.join(',') << '\n';
+    }
+}
+
+QJsonObject toJson(const HalfPowerResult &hp) {
+    return {{"f0", hp.peakFreq},   {"peak_amplitude", hp.peakAmplitude},
+            {"threshold", hp.threshold}, {"f1", hp.f1}, {"f2", hp.f2},
+            {"delta_f", hp.deltaF}, {"loss_factor", hp.lossFactor}};
+}
+
+void writeJson(QTextStream &out, const QList<SweepAnalysis> &results) {
+    QJsonArray array;
+    for (const SweepAnalysis &r : results) {
+        QJsonObject o{{"file", r.path},
+                      {"ok", r.ok()},
+                      {"readings", qint64(r.readings)},
+                      {"frames", qint64(r.frames)},
+                      {"points", qint64(r.points)},
+                      {"fmin", r.fmin},
+                      {"fmax", r.fmax},
+                      {"ms", r.durationMs}};
+        if (!r.ok()) o["error"] = r.error;
+        if (r.hp.ok) o["raw"] = toJson(r.hp);
+        if (r.fitted) {
+            QJsonObject fit = r.fitHp.ok ? toJson(r.fitHp) : QJsonObject();
+            const LorentzianParams &p = r.fitParams;
+            fit["params"] = QJsonObject{{"A0", p.A0}, {"f0", p.f0}, {"eta", p.eta},
+                                        {"alpha", p.alpha}, {"offset", p.offset}};
+            fit["iterations"] = r.fitStats.iterations;
+            fit["sse"] = r.fitStats.sse;
+            fit["converged"] = r.fitStats.converged;
+            o["fit"] = fit;
+        }
+        array.append(o);
+    }
+    out << QJsonDocument(array).toJson();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("LossFactorBatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Loss factor analysis of recorded sweeps (*.lfarec)");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Recordings, or directories to search for them.", "<path>...");
+    QCommandLineOption recursiveOpt({"r", "recursive"}, "Search directories recursively.");
+    QCommandLineOption formatOpt({"f", "format"}, "Output format: csv (default) or json.", "format", "csv");
+    QCommandLineOption outputOpt({"o", "output"}, "Write to file instead of stdout.", "file");
+    QCommandLineOption fminOpt("fmin", "Lower analysis bound in Hz (default: sweep start).", "Hz");
+    QCommandLineOption fmaxOpt("fmax", "Upper analysis bound in Hz (default: sweep end).", "Hz");
+    QCommandLineOption noFitOpt("no-fit", "Skip the skewed Lorentzian fit.");
+    QCommandLineOption jobsOpt({"j", "jobs"}, "Files analysed at once (default: cores).", "n");
+    parser.addOptions({recursiveOpt, formatOpt, outputOpt, fminOpt, fmaxOpt, noFitOpt, jobsOpt});
+    parser.process(app);
+
+    QTextStream err(stderr);
+    const QString format = parser.value(formatOpt);
+    if (format != "csv" && format != "json") {
+        err << "Unknown format " << format << Qt::endl;
+        return 2;
+    }
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(2);
+
+    QStringList files;
+    const auto flags = parser.isSet(recursiveOpt) ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+    for (const QString &path : parser.positionalArguments()) {
+        if (QFileInfo(path).isDir()) {
+            QDirIterator it(path, {"*.lfarec"}, QDir::Files, flags);
+            while (it.hasNext()) files << it.next();
+        } else {
+            files << path;
+        }
+    }
+    files.sort();
+    files.removeDuplicates();
+
+    SweepAnalysisOptions options;
+    options.fmin = parser.value(fminOpt).toFloat();
+    options.fmax = parser.value(fmaxOpt).toFloat();
+    options.fit = !parser.isSet(noFitOpt);
+    if (parser.isSet(jobsOpt))
+        QThreadPool::globalInstance()->setMaxThreadCount(std::max(1, parser.value(jobsOpt).toInt()));
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<SweepAnalysis> results = QtConcurrent::blockingMapped<QList<SweepAnalysis>>(
+        files, [options](const QString &file) { return analyzeRecording(file, options); });
+
+    QFile outFile;
+    if (parser.isSet(outputOpt)) {
+        outFile.setFileName(parser.value(outputOpt));
+        if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << outFile.fileName() << ": " << outFile.errorString() << Qt::endl;
+            return 2;
+        }
+    } else {
+        outFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    QTextStream out(&outFile);
+    if (format == "json")
+        writeJson(out, results);
+    else
+        writeCsv(out, results);
+    out.flush();
+
+    int failed = 0;
+    for (const SweepAnalysis &r : results) {
+        if (r.ok()) continue;
+        ++failed;
+        err << r.path << ": " << r.error << Qt::endl;
+    }
+    err << results.size() << " recordings, " << failed << " failed, "
+        << timer.elapsed() << " ms" << Qt::endl;
+    return failed ? 1 : 0;
+}
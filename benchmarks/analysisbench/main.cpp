@@ -0,0 +1,377 @@
+// Timings and accuracy of the sweep analysis on synthetic resonance curves.
+//
+//   analysisbench [--q Q] [--noise rel] [--skew alpha] [--spacing linear|log|jitter]
+//                 [--f0 Hz] [--min-points n] [--max-points n] [--seed n]
+//
+// Two curve models: the SDOF transmissibility of
+// ModbusReader::generateFakeData() (damping ratio 1/(2Q)) and
+// skewed_lorentzian() (eta 1/Q, skew alpha), sampled over f0 * [0.5, 1.5]
+// as sensor frames, sensor 1 carrying the curve with relative Gaussian
+// noise. For every decade of points from --min-points to --max-points:
+//
+//   ratio      RangeFilteredSeries::update(), frames -> in-range ratio points
+//   halfpower  halfPowerBandwidth() on the raw points
+//   fit-lm     fit_skewed_lorentzian_lm(), the fitter the analysis uses
+//   fit-basic  fit_skewed_lorentzian_basic(), up to 1e5 points
+//   analysis   one cold pass as AnalysisWorker runs it: ResonanceAnalyzer
+//              update and fit, half-power of the fitted curve
+//
+// with time and throughput per call and heap allocations per call. The
+// loss factor of the analysis pass, raw and fitted, is compared with the
+// half-power loss factor of the noise-free curve, and the heap allocations
+// of recording the frames (operator new calls against the store's own
+// chunkAllocations() count, one less: makeFrames()' frequency vector) are
+// listed. Last, the batch kernels under the fitters (lorentzian_sse,
+// lorentzian_eval as residuals, lorentzian_normal_equations) in ns per
+// point for every instruction set the CPU supports, on up to 1e5 points of
+// the skewed Lorentzian.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lorentzian_kernels.h"
+#include "resonanceanalyzer.h"
+
+// Every heap allocation of the process is counted. All the plain, array,
+// sized and aligned forms are replaced and share the helpers below rather
+// than calling each other, so each new is paired with a delete that frees
+// what it allocated.
+static std::atomic<std::uint64_t> g_allocations{0};
+
+static void *countedAlloc(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+static void *countedAlignedAlloc(std::size_t size, std::align_val_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = std::size_t(alignment);
+#ifdef _WIN32
+    if (void *p = _aligned_malloc(size ? size : 1, align))
+        return p;
+#else
+    // aligned_alloc() wants a multiple of the alignment
+    if (void *p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+static void alignedFree(void *p)
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void *operator new(std::size_t size) { return countedAlloc(size); }
+void *operator new[](std::size_t size) { return countedAlloc(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+
+namespace {
+
+enum class Model { Sdof, SkewedLorentzian };
+enum class Spacing { Linear, Log, Jitter };
+
+struct Options {
+    double q = 20;
+    double noise = 0.01;
+    double skew = 0.1;
+    Spacing spacing = Spacing::Linear;
+    double f0 = 17; // generateFakeData()'s natural frequency
+    std::size_t minPoints = 100;
+    std::size_t maxPoints = 1000000;
+    unsigned seed = 1;
+};
+
+const std::size_t BasicFitMaxPoints = 100000;
+const std::size_t KernelPoints = 100000;
+
+double fmin(const Options &o) { return 0.5 * o.f0; }
+double fmax(const Options &o) { return 1.5 * o.f0; }
+
+// Transmissibility |sensor 1 / sensor 2| without noise
+double curve(Model model, const Options &o, double f)
+{
+    if (model == Model::Sdof) {
+        const double zeta = 0.5 / o.q;
+        const double beta = f / o.f0;
+        return 1.0 / std::sqrt(std::pow(1 - beta * beta, 2) + std::pow(2 * zeta * beta, 2));
+    }
+    return skewed_lorentzian(float(f), 10.0f, float(o.f0), float(1.0 / o.q), float(o.skew), 1.0f);
+}
+
+std::vector<double> frequencies(const Options &o, std::size_t n, std::mt19937 &rng)
+{
+    std::vector<double> f(n);
+    const double a = fmin(o), b = fmax(o);
+    const double step = (b - a) / double(std::max<std::size_t>(n - 1, 1));
+    std::uniform_real_distribution<double> jitter(-0.45 * step, 0.45 * step);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double t = double(i) / double(std::max<std::size_t>(n - 1, 1));
+        switch (o.spacing) {
+        case Spacing::Linear: f[i] = a + (b - a) * t; break;
+        case Spacing::Log:    f[i] = a * std::pow(b / a, t); break;
+        case Spacing::Jitter: f[i] = std::clamp(a + (b - a) * t + jitter(rng), a, b); break;
+        }
+    }
+    return f;
+}
+
+// Frames as the aligner produces them: sensor 2 constant, sensor 1 the curve
+void makeFrames(Model model, const Options &o, std::size_t n, FrameStore &frames)
+{
+    std::mt19937 rng(o.seed);
+    std::normal_distribution<double> noise(0.0, o.noise);
+    const std::vector<double> f = frequencies(o, n, rng);
+    frames.clear();
+    for (std::size_t i = 0; i < n; ++i) {
+        const double amp1 = 1e3 * curve(model, o, f[i]) * (1.0 + noise(rng));
+        frames.push_back({std::int64_t(i) * 1000000, float(f[i]), float(amp1), 1e3f});
+    }
+}
+
+// Half-power loss factor the analysis should find with perfect data
+double referenceLossFactor(Model model, const Options &o)
+{
+    const std::size_t n = 1000000;
+    std::vector<float> x(n), y(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = float(fmin(o) + (fmax(o) - fmin(o)) * double(i) / double(n - 1));
+        y[i] = float(curve(model, o, x[i]));
+    }
+    HalfPowerResult hp;
+    halfPowerBandwidth(x, y, hp);
+    return hp.ok ? hp.lossFactor : NAN;
+}
+
+struct Measurement {
+    double msPerCall = 0;
+    double allocsPerCall = 0;
+};
+
+// Repeats fn for at least 200 ms (and at least once)
+Measurement measure(const std::function<void()> &fn)
+{
+    using Clock = std::chrono::steady_clock;
+    fn(); // warm-up: first-touch of buffers and caches
+    const std::uint64_t allocs = g_allocations.load();
+    const auto start = Clock::now();
+    int calls = 0;
+    double elapsedMs = 0;
+    do {
+        fn();
+        ++calls;
+        elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while (elapsedMs < 200 && calls < 100000);
+    return {elapsedMs / calls, double(g_allocations.load() - allocs) / calls};
+}
+
+void report(const char *model, std::size_t points, const char *stage, const Measurement &m)
+{
+    std::printf("%-8s %9zu  %-10s %12.4f %12.2f %10.1f\n", model, points, stage, m.msPerCall,
+                points / (m.msPerCall * 1e3), m.allocsPerCall);
+}
+
+// Start values as ResonanceAnalyzer::fit() picks them without a previous fit
+LorentzianParams initialGuess(const std::vector<float> &x, const std::vector<float> &y)
+{
+    const auto peak = std::max_element(y.begin(), y.end()) - y.begin();
+    LorentzianParams p;
+    p.A0 = y[peak];
+    p.f0 = x[peak];
+    p.eta = 0.05f;
+    p.alpha = 0.0f;
+    p.offset = *std::min_element(y.begin(), y.end());
+    return p;
+}
+
+// ns per point of each batch kernel, forcing every supported ISA in turn
+void benchKernels(const Options &o)
+{
+    const std::size_t n = std::min(o.maxPoints, KernelPoints);
+    std::mt19937 rng(o.seed);
+    const std::vector<double> f = frequencies(o, n, rng);
+    std::vector<float> x(n), y(n), out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = float(f[i]);
+        y[i] = float(curve(Model::SkewedLorentzian, o, f[i]));
+    }
+    // Slightly off the curve's own parameters, as in a fit iteration
+    const double p[5] = {10.5, 1.01 * o.f0, 1.1 / o.q, o.skew, 1.0};
+    double JTJ[5][5], JTr[5];
+    volatile double sink = 0; // keeps the SSE passes from being optimized away
+
+    std::printf("\n%-10s %9s %12s %12s %12s\n", "isa", "points", "sse ns/pt", "eval ns/pt",
+                "normal ns/pt");
+    const LorentzianIsa active = lorentzian_isa();
+    for (LorentzianIsa isa : {LorentzianIsa::Scalar, LorentzianIsa::SSE2, LorentzianIsa::AVX2}) {
+        lorentzian_set_isa(isa);
+        if (lorentzian_isa() != isa) {
+            std::printf("%-10s not supported\n", lorentzian_isa_name(isa));
+            continue;
+        }
+        const double perPoint = 1e6 / double(n);
+        const Measurement sse = measure([&]() { sink = lorentzian_sse(x.data(), y.data(), n, p); });
+        const Measurement eval = measure([&]() { lorentzian_eval(x.data(), y.data(), n, p, out.data()); });
+        const Measurement normal = measure([&]() {
+            sink = lorentzian_normal_equations(x.data(), y.data(), n, p, JTJ, JTr);
+        });
+        std::printf("%-10s %9zu %12.3f %12.3f %12.3f\n", lorentzian_isa_name(isa), n,
+                    sse.msPerCall * perPoint, eval.msPerCall * perPoint, normal.msPerCall * perPoint);
+    }
+    lorentzian_set_isa(active);
+}
+
+bool parse(int argc, char *argv[], Options &o)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (arg == "--q") o.q = std::atof(value);
+        else if (arg == "--noise") o.noise = std::atof(value);
+        else if (arg == "--skew") o.skew = std::atof(value);
+        else if (arg == "--f0") o.f0 = std::atof(value);
+        else if (arg == "--min-points") o.minPoints = std::size_t(std::atof(value));
+        else if (arg == "--max-points") o.maxPoints = std::size_t(std::atof(value));
+        else if (arg == "--seed") o.seed = unsigned(std::atoi(value));
+        else if (arg == "--spacing") {
+            if (!std::strcmp(value, "linear")) o.spacing = Spacing::Linear;
+            else if (!std::strcmp(value, "log")) o.spacing = Spacing::Log;
+            else if (!std::strcmp(value, "jitter")) o.spacing = Spacing::Jitter;
+            else return false;
+        } else {
+            return false;
+        }
+    }
+    return o.q > 0 && o.f0 > 0 && o.minPoints >= 10 && o.maxPoints >= o.minPoints;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options o;
+    if (!parse(argc, argv, o)) {
+        std::fprintf(stderr,
+                     "usage: analysisbench [--q Q] [--noise rel] [--skew alpha] "
+                     "[--spacing linear|log|jitter] [--f0 Hz] [--min-points n] "
+                     "[--max-points n] [--seed n]\n");
+        return 2;
+    }
+
+    std::printf("Q %g, noise %g, skew %g, f0 %g Hz, %s spacing\n\n", o.q, o.noise, o.skew, o.f0,
+                o.spacing == Spacing::Linear ? "linear" : o.spacing == Spacing::Log ? "log" : "jittered");
+    std::printf("%-8s %9s  %-10s %12s %12s %10s\n", "model", "points", "stage", "ms/call", "Mpts/s",
+                "allocs");
+
+    struct Accuracy {
+        const char *model;
+        std::size_t points;
+        double reference, raw, fit;
+    };
+    std::vector<Accuracy> accuracy;
+
+    struct Recording {
+        const char *model;
+        std::size_t points;
+        std::uint64_t allocations, chunkAllocations;
+    };
+    std::vector<Recording> recording;
+
+    for (Model model : {Model::Sdof, Model::SkewedLorentzian}) {
+        const char *name = model == Model::Sdof ? "sdof" : "lorentz";
+        const double reference = referenceLossFactor(model, o);
+
+        for (std::size_t n = o.minPoints; n <= o.maxPoints; n *= 10) {
+            FrameStore frames;
+            const std::uint64_t allocs = g_allocations.load();
+            makeFrames(model, o, n, frames);
+            recording.push_back({name, n, g_allocations.load() - allocs, frames.chunkAllocations()});
+            const FrameSnapshot snapshot = frames.snapshot();
+
+            RangeFilteredSeries series;
+            report(name, n, "ratio", measure([&]() {
+                       series.setRange(float(fmin(o)), float(fmax(o)));
+                       series.update(snapshot);
+                   }));
+            const std::vector<float> &x = series.x();
+            const std::vector<float> &y = series.y();
+
+            HalfPowerResult hp;
+            report(name, n, "halfpower", measure([&]() { halfPowerBandwidth(x, y, hp); }));
+
+            const LorentzianParams guess = initialGuess(x, y);
+            report(name, n, "fit-lm", measure([&]() {
+                       LorentzianParams p = guess;
+                       fit_skewed_lorentzian_lm(x, y, p.A0, p.f0, p.eta, p.alpha, p.offset);
+                   }));
+            if (n <= BasicFitMaxPoints)
+                report(name, n, "fit-basic", measure([&]() {
+                           LorentzianParams p = guess;
+                           fit_skewed_lorentzian_basic(x, y, p.A0, p.f0, p.eta, p.alpha, p.offset);
+                       }));
+
+            HalfPowerResult raw, fitted;
+            report(name, n, "analysis", measure([&]() {
+                       ResonanceAnalyzer analyzer;
+                       analyzer.setFrequencyRange(float(fmin(o)), float(fmax(o)));
+                       analyzer.update(snapshot);
+                       raw = analyzer.halfPower();
+                       std::vector<float> fitX, fitY;
+                       fitted = HalfPowerResult();
+                       if (analyzer.fit(fitX, fitY))
+                           halfPowerBandwidth(fitX, fitY, fitted);
+                   }));
+            accuracy.push_back({name, n, reference, raw.ok ? raw.lossFactor : NAN,
+                                fitted.ok ? fitted.lossFactor : NAN});
+        }
+    }
+
+    std::printf("\n%-8s %9s %12s %12s %9s %12s %9s\n", "model", "points", "reference", "raw",
+                "raw err%", "fit", "fit err%");
+    for (const Accuracy &a : accuracy) {
+        std::printf("%-8s %9zu %12.5f %12.5f %9.2f %12.5f %9.2f\n", a.model, a.points, a.reference,
+                    a.raw, 100 * (a.raw - a.reference) / a.reference, a.fit,
+                    100 * (a.fit - a.reference) / a.reference);
+    }
+
+    std::printf("\n%-8s %9s %12s %12s\n", "model", "points", "allocs", "chunk allocs");
+    for (const Recording &r : recording)
+        std::printf("%-8s %9zu %12llu %12llu\n", r.model, r.points,
+                    (unsigned long long)r.allocations, (unsigned long long)r.chunkAllocations);
+
+    benchKernels(o);
+    return 0;
+}
@@ -0,0 +1,6 @@
+# Stand-alone benchmark programs, not part of the application build
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    analysisbench \
+    xlsxbench
@@ -0,0 +1,296 @@
+// Timings of the QXlsx write paths used by the report export.
+//
+//   xlsxbench [cells]     (default 100000, written as 4 columns)
+//
+// The columnar cell storage is checked first (overwrites, merges and
+// shared formulas over dense cells, and a save/reload round trip); the run
+// fails with exit code 1 if it does not hold up. The write paths are
+// followed by the sheet XML serialization time of a 1M-cell sheet, the
+// save time / size of a filled report template per compression preset and
+// the cost of loading the template against cloning the parsed one.
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QTextStream>
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "xlsxcellformula.h"
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+namespace {
+
+const int Columns = 4;
+
+struct Timing {
+    double writeMs = 0;
+    double saveMs  = 0;
+    qint64 bytes   = 0;
+};
+
+std::vector<float> makeColumn(size_t n, float scale)
+{
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = scale * (1.0f + std::sin(0.001f * float(i)));
+    return v;
+}
+
+Timing run(const std::function<void(Document &)> &fill)
+{
+    Document xlsx;
+    Timing t;
+    QElapsedTimer timer;
+
+    timer.start();
+    fill(xlsx);
+    t.writeMs = timer.nsecsElapsed() / 1e6;
+
+    QBuffer out;
+    out.open(QIODevice::WriteOnly);
+    timer.restart();
+    xlsx.saveAs(&out);
+    t.saveMs = timer.nsecsElapsed() / 1e6;
+    t.bytes  = out.size();
+    return t;
+}
+
+void report(QTextStream &out, const QString &name, const Timing &t)
+{
+    out << qSetFieldWidth(28) << Qt::left << name << qSetFieldWidth(12) << Qt::right
+        << QString::number(t.writeMs, 'f', 1) << QString::number(t.saveMs, 'f', 1)
+        << QString::number(t.bytes / 1024) << qSetFieldWidth(0) << Qt::endl;
+}
+
+// Saves and loads the document again
+std::unique_ptr<Document> reloaded(Document &xlsx)
+{
+    QByteArray bytes;
+    {
+        QBuffer file(&bytes);
+        file.open(QIODevice::WriteOnly);
+        xlsx.saveAs(&file);
+    }
+    QBuffer file(&bytes);
+    file.open(QIODevice::ReadOnly);
+    return std::make_unique<Document>(&file);
+}
+
+bool checkColumnar(QTextStream &out)
+{
+    bool ok = true;
+    auto expect = [&](bool condition, const char *what) {
+        if (!condition) {
+            out << "FAILED: " << what << Qt::endl;
+            ok = false;
+        }
+    };
+
+    Format bold;
+    bold.setFontBold(true);
+
+    // Formatted block over a plain one: each cell stored (and saved) once
+    {
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        sheet->setCellStorage(Worksheet::CS_Columnar);
+        const double plain[]     = {1, 2, 3, 4, 5, 6};
+        const double formatted[] = {30, 40};
+        sheet->writeColumn(1, 1, plain, std::size(plain));
+        sheet->writeColumn(3, 1, formatted, std::size(formatted), bold);
+
+        const QByteArray xml = sheet->saveToXmlData();
+        expect(xml.count("r=\"A3\"") == 1 && xml.count("r=\"A4\"") == 1,
+               "formatted block over dense cells writes one <c> per cell");
+
+        const std::unique_ptr<Document> loaded = reloaded(xlsx);
+        const double expected[] = {1, 2, 30, 40, 5, 6};
+        for (int i = 0; i < int(std::size(expected)); ++i)
+            expect(loaded->read(i + 1, 1).toDouble() == expected[i],
+                   "formatted block over dense cells, values after reload");
+        auto cell = loaded->cellAt(3, 1);
+        expect(cell && cell->format().fontBold(), "formatted block over dense cells, format after reload");
+    }
+
+    // Merging dense cells formats the top-left one
+    {
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        sheet->setCellStorage(Worksheet::CS_Columnar);
+        const double values[] = {1, 2};
+        sheet->writeColumn(1, 1, values, std::size(values));
+        sheet->writeColumn(1, 2, values, std::size(values));
+        sheet->mergeCells(CellRange(1, 1, 2, 2), bold);
+
+        auto cell = sheet->cellAt(1, 1);
+        expect(cell && cell->format().fontBold() && cell->value().toDouble() == 1,
+               "merge over dense cells keeps value and format");
+        const std::unique_ptr<Document> loaded = reloaded(xlsx);
+        cell = loaded->cellAt(1, 1);
+        expect(cell && cell->format().fontBold(), "merge over dense cells, format after reload");
+    }
+
+    // A shared formula over dense cells reaches every cell of its range
+    {
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        sheet->setCellStorage(Worksheet::CS_Columnar);
+        const double values[] = {1, 2, 3};
+        sheet->writeColumn(1, 1, values, std::size(values));
+        sheet->writeColumn(1, 2, values, std::size(values));
+        sheet->writeFormula(1, 2, CellFormula("A1*2", CellRange(1, 2, 3, 2), CellFormula::SharedType));
+
+        for (int row = 2; row <= 3; ++row) {
+            auto cell = sheet->cellAt(row, 2);
+            expect(cell && cell->hasFormula() &&
+                       cell->formula().formulaType() == CellFormula::SharedType,
+                   "shared formula over dense cells");
+        }
+    }
+
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const size_t cells = argc > 1 ? QString(argv[1]).toULongLong() : 100000;
+    const size_t rows  = cells / Columns;
+
+    std::vector<std::vector<float>> data;
+    for (int c = 0; c < Columns; ++c)
+        data.push_back(makeColumn(rows, float(c + 1)));
+
+    QTextStream out(stdout);
+    if (!checkColumnar(out))
+        return 1;
+
+    out << rows * Columns << " cells (" << rows << " rows x " << Columns << " columns)" << Qt::endl;
+    out << qSetFieldWidth(28) << Qt::left << "path" << qSetFieldWidth(12) << Qt::right
+        << "write ms" << "save ms" << "KiB" << qSetFieldWidth(0) << Qt::endl;
+
+    // What the export did before: an "A123" string per cell
+    report(out, "write(QString, float)", run([&](Document &xlsx) {
+               const char letters[] = "ABCD";
+               for (int c = 0; c < Columns; ++c)
+                   for (size_t i = 0; i < rows; ++i)
+                       xlsx.write(QLatin1Char(letters[c]) + QString::number(i + 2), data[c][i]);
+           }));
+
+    report(out, "writeNumeric(row, col)", run([&](Document &xlsx) {
+               Worksheet *sheet = xlsx.currentWorksheet();
+               for (int c = 0; c < Columns; ++c)
+                   for (size_t i = 0; i < rows; ++i)
+                       sheet->writeNumeric(int(i) + 2, c + 1, data[c][i]);
+           }));
+
+    report(out, "writeColumn(float *)", run([&](Document &xlsx) {
+               Worksheet *sheet = xlsx.currentWorksheet();
+               for (int c = 0; c < Columns; ++c)
+                   sheet->writeColumn(2, c + 1, data[c].data(), rows);
+           }));
+
+    report(out, "writeColumn, columnar", run([&](Document &xlsx) {
+               Worksheet *sheet = xlsx.currentWorksheet();
+               sheet->setCellStorage(Worksheet::CS_Columnar);
+               for (int c = 0; c < Columns; ++c)
+                   sheet->writeColumn(2, c + 1, data[c].data(), rows);
+           }));
+
+    report(out, "setStreamedColumns", run([&](Document &xlsx) {
+               xlsx.currentWorksheet()->setStreamedColumns(2, 1, data);
+           }));
+
+    // Sheet XML serialization alone, 1M stored cells
+    {
+        const size_t bigRows = 1000000 / Columns;
+        const std::vector<float> column = makeColumn(bigRows, 1.0f);
+        Document xlsx;
+        Worksheet *sheet = xlsx.currentWorksheet();
+        for (int c = 0; c < Columns; ++c)
+            sheet->writeColumn(1, c + 1, column.data(), column.size());
+
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray xml = sheet->saveToXmlData();
+        out << Qt::endl
+            << "sheet XML, " << bigRows * Columns << " cells: "
+            << QString::number(timer.nsecsElapsed() / 1e6, 'f', 1) << " ms, "
+            << xml.size() / 1024 << " KiB" << Qt::endl;
+    }
+
+    // Compression presets on the report template, filled like an export
+    out << Qt::endl << "report template, " << rows << " raw data rows" << Qt::endl;
+    QImage image(1200, 700, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    {
+        QPainter painter(&image);
+        painter.setPen(QPen(Qt::blue, 2));
+        for (int x = 1; x < image.width(); ++x)
+            painter.drawLine(x - 1,
+                             int(350 - 300 * std::sin(0.01 * (x - 1))),
+                             x,
+                             int(350 - 300 * std::sin(0.01 * x)));
+    }
+    const std::pair<const char *, CompressionPolicy::Preset> presets[] = {
+        {"Balanced", CompressionPolicy::Balanced},
+        {"Fast", CompressionPolicy::Fast},
+        {"Small", CompressionPolicy::Small},
+        {"StoreOnly", CompressionPolicy::StoreOnly},
+    };
+    for (const auto &preset : presets) {
+        Document xlsx(QStringLiteral(REPORT_TEMPLATE));
+        const double results[] = {1000, 0.5, 0.35, 990, 1010, 20, 0.02};
+        xlsx.currentWorksheet()->writeColumn(6, 2, results, std::size(results));
+        xlsx.insertImage(14, 0, image);
+        xlsx.selectSheet(QStringLiteral("Raw data"));
+        xlsx.currentWorksheet()->setStreamedColumns(2, 1, data);
+        xlsx.selectSheet(QStringLiteral("Report"));
+
+        QBuffer file;
+        file.open(QIODevice::WriteOnly);
+        QElapsedTimer timer;
+        timer.start();
+        xlsx.saveAs(&file, CompressionPolicy(preset.second));
+        Timing t;
+        t.saveMs = timer.nsecsElapsed() / 1e6;
+        t.bytes  = file.size();
+        report(out, QLatin1String(preset.first), t);
+    }
+
+    // Template reuse: parse per export, or parse once and clone
+    {
+        const int exports = 50;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < exports; ++i)
+            Document xlsx(QStringLiteral(REPORT_TEMPLATE));
+        const double loadMs = timer.nsecsElapsed() / 1e6 / exports;
+
+        Document parsed(QStringLiteral(REPORT_TEMPLATE));
+        timer.restart();
+        for (int i = 0; i < exports; ++i)
+            std::unique_ptr<Document> clone(parsed.clone());
+        const double cloneMs = timer.nsecsElapsed() / 1e6 / exports;
+
+        out << Qt::endl
+            << "template load " << QString::number(loadMs, 'f', 3) << " ms, clone "
+            << QString::number(cloneMs, 'f', 3) << " ms" << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+QT       += core gui
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = xlsxbench
+
+SOURCES += \
+    main.cpp
+
+# The report template of the application, for the compression presets
+DEFINES += REPORT_TEMPLATE=\\\"$$PWD/../../report_template.xlsx\\\"
+
+QXLSX_PARENTPATH=$$PWD/../../QXlsx/
+QXLSX_HEADERPATH=$$PWD/../../QXlsx/header/
+QXLSX_SOURCEPATH=$$PWD/../../QXlsx/source/
+include($$PWD/../../QXlsx/QXlsx.pri)
@@ -0,0 +1,107 @@
+#include "chartdecimator.h"
+
+#include <algorithm>
+
+void MinMaxDecimator::setView(float xmin, float xmax, int columns)
+{
+    columns = std::max(columns, 1);
+    if (!m_grids.empty()) {
+        const Grid &cur = m_grids[m_active];
+        if (cur.xmin == xmin && cur.xmax == xmax && cur.columns == columns)
+            return;
+    }
+    m_viewChanged = true;
+
+    for (std::size_t i = 0; i < m_grids.size(); ++i) {
+        const Grid &g = m_grids[i];
+        if (g.xmin == xmin && g.xmax == xmax && g.columns == columns) {
+            m_active = i;
+            return;
+        }
+    }
+
+    Grid g;
+    g.xmin = xmin;
+    g.xmax = xmax;
+    g.columns = columns;
+    g.buckets.resize(columns);
+
+    if (m_grids.size() < MaxCachedViews) {
+        m_grids.push_back(std::move(g));
+        m_active = m_grids.size() - 1;
+    } else {
+        // replace the least recently used view
+        auto lru = std::min_element(m_grids.begin(), m_grids.end(),
+                                    [](const Grid &a, const Grid &b) { return a.lastUsed < b.lastUsed; });
+        *lru = std::move(g);
+        m_active = lru - m_grids.begin();
+    }
+}
+
+void MinMaxDecimator::reset()
+{
+    for (Grid &g : m_grids) {
+        std::fill(g.buckets.begin(), g.buckets.end(), Bucket());
+        g.consumed = 0;
+    }
+    m_viewChanged = true;
+}
+
+bool MinMaxDecimator::update(const std::vector<float> &x, const std::vector<float> &y, std::uint64_t epoch)
+{
+    if (m_grids.empty()) return false;
+    if (epoch != m_epoch) {
+        m_epoch = epoch;
+        reset();
+    }
+
+    Grid &g = m_grids[m_active];
+    g.lastUsed = ++m_useClock;
+
+    const std::size_t n = std::min(x.size(), y.size());
+    if (g.consumed > n) {
+        // source shrank without a new epoch: start this view over
+        std::fill(g.buckets.begin(), g.buckets.end(), Bucket());
+        g.consumed = 0;
+    }
+
+    bool changed = m_viewChanged;
+    const double scale = g.xmax > g.xmin ? g.columns / double(g.xmax - g.xmin) : 0.0;
+    for (std::size_t i = g.consumed; i < n; ++i) {
+        if (x[i] < g.xmin || x[i] > g.xmax) continue;
+        int c = std::min(int((x[i] - g.xmin) * scale), g.columns - 1);
+        Bucket &b = g.buckets[c];
+        if (b.minIdx < 0) {
+            b.minIdx = b.maxIdx = std::int32_t(i);
+            changed = true;
+            continue;
+        }
+        if (y[i] < y[b.minIdx]) { b.minIdx = std::int32_t(i); changed = true; }
+        if (y[i] > y[b.maxIdx]) { b.maxIdx = std::int32_t(i); changed = true; }
+    }
+    g.consumed = n;
+
+    if (changed)
+        rebuildOutput(g, x, y);
+    m_viewChanged = false;
+    return changed;
+}
+
+void MinMaxDecimator::rebuildOutput(const Grid &g, const std::vector<float> &x, const std::vector<float> &y)
+{
+    m_outX.clear();
+    m_outY.clear();
+    m_outX.reserve(2 * g.columns);
+    m_outY.reserve(2 * g.columns);
+    for (const Bucket &b : g.buckets) {
+        if (b.minIdx < 0) continue;
+        std::int32_t first = std::min(b.minIdx, b.maxIdx);
+        std::int32_t second = std::max(b.minIdx, b.maxIdx);
+        m_outX.push_back(x[first]);
+        m_outY.push_back(y[first]);
+        if (second != first) {
+            m_outX.push_back(x[second]);
+            m_outY.push_back(y[second]);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CHARTDECIMATOR_H
+#define CHARTDECIMATOR_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Min/max-per-pixel decimation of a growing (x, y) series for display.
+// The x range of the view is split into one bucket per pixel column; each
+// bucket keeps the indices of its lowest and highest point, so every peak
+// and dip survives while the output never exceeds two points per column.
+//
+// Bucket grids are cached per view (x range and column count). Data is only
+// ever appended, so switching back to a cached view costs just the points
+// appended since it was last shown. A new epoch of the source discards all
+// grids.
+class MinMaxDecimator {
+public:
+    void setView(float xmin, float xmax, int columns);
+    void reset();
+
+    // Folds points appended since the last call into the active grid and
+    // returns true if the decimated output changed.
+    bool update(const std::vector<float> &x, const std::vector<float> &y, std::uint64_t epoch);
+
+    // Decimated points in ascending x, min/max of a column in recorded order
+    const std::vector<float> &x() const { return m_outX; }
+    const std::vector<float> &y() const { return m_outY; }
+
+    static constexpr std::size_t MaxCachedViews = 4;
+
+private:
+    struct Bucket {
+        std::int32_t minIdx = -1;
+        std::int32_t maxIdx = -1;
+    };
+
+    struct Grid {
+        float xmin = 0, xmax = 0;
+        int columns = 0;
+        std::vector<Bucket> buckets;
+        std::size_t consumed = 0;     // source points folded in
+        std::uint64_t lastUsed = 0;
+    };
+
+    std::vector<Grid> m_grids;
+    std::size_t m_active = 0;         // index into m_grids
+    std::uint64_t m_epoch = 0;
+    std::uint64_t m_useClock = 0;
+    bool m_viewChanged = true;
+    std::vector<float> m_outX, m_outY;
+
+    void rebuildOutput(const Grid &g, const std::vector<float> &x, const std::vector<float> &y);
+};
+
+#endif // CHARTDECIMATOR_H
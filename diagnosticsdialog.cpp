@@ -0,0 +1,71 @@
+#include "diagnosticsdialog.h"
+#include "ui_diagnosticsdialog.h"
+#include <QDateTime>
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QMessageBox>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QTimer>
+#include "metrics.h"
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::DiagnosticsDialog)
+    , refreshTimer(new QTimer(this))
+{
+    ui->setupUi(this);
+    ui->metricsText->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    refreshTimer->setInterval(1000);
+    connect(refreshTimer, &QTimer::timeout, this, &DiagnosticsDialog::refresh);
+}
+
+DiagnosticsDialog::~DiagnosticsDialog()
+{
+    delete ui;
+}
+
+void DiagnosticsDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    refresh();
+    refreshTimer->start();
+}
+
+void DiagnosticsDialog::hideEvent(QHideEvent *event)
+{
+    refreshTimer->stop();
+    QDialog::hideEvent(event);
+}
+
+void DiagnosticsDialog::refresh()
+{
+    // Keep the scroll position across refreshes
+    QScrollBar *v = ui->metricsText->verticalScrollBar();
+    QScrollBar *h = ui->metricsText->horizontalScrollBar();
+    const int vPos = v->value(), hPos = h->value();
+    ui->metricsText->setPlainText(Metrics::instance().report());
+    v->setValue(vPos);
+    h->setValue(hPos);
+}
+
+void DiagnosticsDialog::on_resetButton_clicked()
+{
+    Metrics::instance().reset();
+    refresh();
+}
+
+void DiagnosticsDialog::on_saveButton_clicked()
+{
+    const QString suggested =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/Metrics_" +
+        QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".txt";
+    const QString path = QFileDialog::getSaveFileName(this, "Save Metrics", suggested, "Text files (*.txt)");
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (!Metrics::instance().dump(path, &error))
+        QMessageBox::warning(this, "Save Failed", error);
+}
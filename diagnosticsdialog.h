@@ -0,0 +1,36 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QTimer;
+
+namespace Ui {
+class DiagnosticsDialog;
+}
+
+// Live view of the metrics registry: acquisition, chart, analysis and
+// export counters and latencies, refreshed every second while shown.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+    ~DiagnosticsDialog();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void on_resetButton_clicked();
+    void on_saveButton_clicked();
+
+private:
+    Ui::DiagnosticsDialog *ui;
+    QTimer *refreshTimer;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
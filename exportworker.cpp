@@ -0,0 +1,129 @@
+#include "exportworker.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include "metrics.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+ExportWorker::ExportWorker(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<ExportResult>();
+}
+
+ExportWorker::~ExportWorker() = default;
+
+bool ExportWorker::submit(const ExportJob &job) {
+    bool idle = false;
+    if (!m_busy.compare_exchange_strong(idle, true)) return false;
+    m_cancel = false;
+    QMetaObject::invokeMethod(this, [this, job]() { run(job); }, Qt::QueuedConnection);
+    return true;
+}
+
+void ExportWorker::cancel() {
+    m_cancel = true;
+}
+
+void ExportWorker::run(const ExportJob &job) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ExportResult result;
+    result.path = job.path;
+    if (build(job, result))
+        result.status = ExportResult::Saved;
+    else if (m_cancel)
+        result.status = ExportResult::Cancelled;
+    const qint64 ns = timer.nsecsElapsed();
+    result.durationMs = ns / 1e6;
+
+    // Once per export, so the registry lookups do not matter here
+    Metrics &metrics = Metrics::instance();
+    switch (result.status) {
+    case ExportResult::Saved:
+        metrics.histogram("export.saved").record(ns);
+        break;
+    case ExportResult::Cancelled:
+        metrics.counter("export.cancelled").add();
+        break;
+    case ExportResult::Failed:
+        metrics.counter("export.failed").add();
+        break;
+    }
+
+    m_busy = false;
+    emit finished(result);
+}
+
+bool ExportWorker::build(const ExportJob &job, ExportResult &result) {
+    auto cancelled = [this]() { return m_cancel.load(); };
+
+    emit progress(0);
+    if (!m_template)
+        m_template = std::make_unique<Document>(":/report_template.xlsx");
+
+    // Fill a copy of the parsed template
+    std::unique_ptr<Document> doc(m_template->clone());
+    if (!doc)
+        doc = std::make_unique<Document>(":/report_template.xlsx");
+    Document &xlsx = *doc;
+    if (!xlsx.workbook()->sheet(0)) {
+        result.error = "Sheet 'Results' not found in template.";
+        return false;
+    }
+    if (cancelled()) return false;
+    emit progress(10);
+
+    // Fill named cells B6:B12
+    xlsx.currentWorksheet()->writeColumn(6, 2, job.results.data(), job.results.size());
+    // The chart is encoded once, here, and stored as is; it keeps the size
+    // it had on screen whatever its resolution
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    job.chart.save(&buffer, "PNG");
+    xlsx.insertImage(14, 0, png, job.chart.deviceIndependentSize().toSize());
+    if (cancelled()) return false;
+    emit progress(30);
+
+    // Rows below the header are serialized straight into the file on save
+    std::vector<std::vector<float>> columns(4);
+    for (auto &column : columns) column.reserve(job.frames.size());
+    job.frames.forEach(0, [&](const AlignedFrame &fr) {
+        columns[0].push_back(fr.freq);
+        columns[1].push_back(fr.amp1);
+        columns[2].push_back(fr.amp2);
+        columns[3].push_back(fr.ratio());
+    });
+    xlsx.selectSheet("Raw data");
+    xlsx.currentWorksheet()->setStreamedColumns(2, 1, std::move(columns));
+    xlsx.selectSheet("Report");
+    emit progress(40);
+
+    QSaveFile file(job.path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.error = file.errorString();
+        return false;
+    }
+    // 40..99 % as the parts are written; a cancel stops after the current part
+    const bool saved = xlsx.saveAs(&file, job.policy, [&](int written, int parts) {
+        emit progress(40 + 59 * written / parts);
+        return !cancelled();
+    });
+    if (cancelled()) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!saved) {
+        result.error = "Failed to save file.";
+        return false;
+    }
+    if (!file.commit()) {
+        result.error = file.errorString();
+        return false;
+    }
+    emit progress(100);
+    return true;
+}
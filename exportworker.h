@@ -0,0 +1,69 @@
+#ifndef EXPORTWORKER_H
+#define EXPORTWORKER_H
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QMetaType>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <memory>
+#include "samplerecord.h"
+#include "xlsxdocument.h"
+
+// Everything a report export needs, captured on the GUI thread
+struct ExportJob {
+    QString path;
+    // B6:B12: peak frequency, peak amplitude, threshold, f1, f2, bandwidth, loss factor
+    std::array<double, 7> results{};
+    QImage chart;                       // screenshot, taken by the GUI
+    FrameSnapshot frames;               // raw data sheet rows
+    QXlsx::CompressionPolicy policy;
+};
+
+struct ExportResult {
+    enum Status { Saved, Cancelled, Failed };
+
+    QString path;
+    Status status = Failed;
+    QString error;                      // Failed only
+    double durationMs = 0;
+};
+
+Q_DECLARE_METATYPE(ExportResult)
+
+// Builds and saves the report workbook on its own thread. The template is
+// parsed there on the first job and cloned for every export. The file is
+// written through QSaveFile, so a cancelled or failed export never leaves a
+// partial report behind; cancellation is checked between the stages and,
+// while saving, after each part written to the archive.
+class ExportWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ExportWorker(QObject *parent = nullptr);
+    ~ExportWorker();
+
+    // Any thread. Returns false, and drops the job, while an export runs.
+    bool submit(const ExportJob &job);
+    void cancel();
+    bool busy() const { return m_busy.load(); }
+
+signals:
+    void progress(int percent);
+    void finished(const ExportResult &result);
+
+private:
+    std::atomic<bool> m_busy{false};
+    std::atomic<bool> m_cancel{false};
+
+    // worker thread only
+    std::unique_ptr<QXlsx::Document> m_template;
+
+    void run(const ExportJob &job);
+    bool build(const ExportJob &job, ExportResult &result);
+};
+
+#endif // EXPORTWORKER_H
@@ -1,9 +1,10 @@
 #include <QFile>
 #include <QTextStream>
 #include <QString>
+#include <algorithm>
 
-#include "skewed_lorentzian_fit.hpp"
 #include "livechartwidget.h"
+#include "logging.h"
 
 LiveChartWidget::LiveChartWidget(ModbusReader* reader, QWidget *parent)
     : QWidget(parent), chart(new QChart()),
@@ -24,14 +25,42 @@ LiveChartWidget::LiveChartWidget(ModbusReader* reader, QWidget *parent)
     axisX->setRange(1, 10);
     axisY->setRange(0, 1);
 
+    // Persistent series, updated in place by refreshChart()
+    rawLine = static_cast<QLineSeries*>(createSeries("Raw", QPen(QColorConstants::Blue, 2), true));
+    rawScatter = static_cast<QScatterSeries*>(createSeries("Raw", QPen(QColorConstants::Blue, 2), false));
+    rawScatter->setMarkerSize(5);
+    fitSeries = createSeries("Fit", QPen(QColorConstants::Blue, 2));
+    thresholdLine = createSeries("Threshold", QPen(QColorConstants::Green));
+    f1Line = createSeries("f1", QPen(QColorConstants::Red));
+    f2Line = createSeries("f2", QPen(QColorConstants::Red));
+    peakLine = createSeries("f_peak", QPen(QColorConstants::Gray));
+    for (QXYSeries *s : { static_cast<QXYSeries*>(rawScatter), fitSeries, thresholdLine, f1Line, f2Line, peakLine })
+        s->setVisible(false);
+
+    // Fits and half-power analysis run off the GUI thread; only results are applied here
+    analysisThread = new QThread(this);
+    analysisThread->setObjectName("analysis");
+    worker = new AnalysisWorker;
+    worker->moveToThread(analysisThread);
+    connect(analysisThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &AnalysisWorker::resultReady, this, &LiveChartWidget::applyAnalysis);
+    analysisThread->start();
+
     updateTimer = new QTimer(this);
     connect(updateTimer, &QTimer::timeout, this, &LiveChartWidget::updateChart);
     updateTimer->start(500);
 }
 
+LiveChartWidget::~LiveChartWidget()
+{
+    analysisThread->quit();
+    analysisThread->wait();
+}
+
 void LiveChartWidget::setFreqInterval(qreal start_freq, qreal end_freq){
     this->start_freq = start_freq;
     this->end_freq = end_freq;
+    series.setRange(start_freq, end_freq);
     axisX->setRange(start_freq, end_freq);
 }
 
@@ -44,7 +73,7 @@ void LiveChartWidget::saveVectorsToCSV(const QString& filePath,
 {
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Could not open file for writing:" << file.errorString();
+        qCWarning(lcChart) << "Could not open file for writing:" << file.errorString();
         return;
     }
 
@@ -64,257 +93,230 @@ void LiveChartWidget::saveVectorsToCSV(const QString& filePath,
     }
 
     file.close();
-    qDebug() << "Data saved to" << filePath;
-}
-
-bool LiveChartWidget::fitData(const std::vector<float>& frequencies,
-                              const std::vector<float>& amplitudes,
-                              std::vector<float>& fitX,
-                              std::vector<float>& fitY)
-{
-    if (frequencies.size() < 3 || amplitudes.size() < 3) return false;
-
-    // Initial guesses
-    float A0 = *std::max_element(amplitudes.begin(), amplitudes.end());
-    auto itmax = std::max_element(amplitudes.begin(), amplitudes.end());
-    size_t idx_max = std::distance(amplitudes.begin(), itmax);
-    float f0 = frequencies[idx_max];
-    float eta = 0.05, alpha = 0.0;
-    float offset = *std::min_element(amplitudes.begin(), amplitudes.end());
-
-    // Fit curve (first pass)
-    fit_skewed_lorentzian_basic(frequencies, amplitudes, A0, f0, eta, alpha, offset);
-
-    // Residual filtering
-    std::vector<float> residuals(frequencies.size());
-    for (size_t i = 0; i < frequencies.size(); ++i)
-        residuals[i] = amplitudes[i] - skewed_lorentzian(frequencies[i], A0, f0, eta, alpha, offset);
-
-    float res_mean = mean(residuals);
-    float res_std  = stddev(residuals, res_mean);
-    float threshold = 2.0f * res_std;
-
-    std::vector<float> xf, yf;
-    for (size_t i = 0; i < frequencies.size(); ++i) {
-        if (std::abs(residuals[i]) < threshold) {
-            xf.push_back(frequencies[i]);
-            yf.push_back(amplitudes[i]);
-        }
-    }
-    if (xf.size() < 3) { xf = frequencies; yf = amplitudes; }
-
-    // Refit on filtered data
-    fit_skewed_lorentzian_basic(xf, yf, A0, f0, eta, alpha, offset);
-
-    // Generate dense fitted curve
-    fitX = linspace(frequencies.front(), frequencies.back(), 150);
-    fitY.resize(fitX.size());
-    for (size_t i = 0; i < fitX.size(); ++i)
-        fitY[i] = skewed_lorentzian(fitX[i], A0, f0, eta, alpha, offset);
-
-    return true;
+    qCDebug(lcChart) << "Data saved to" << filePath;
 }
 
-// Helper to create a line series from two vectors
-QXYSeries* LiveChartWidget::createSeries(const QVector<float>& x, const QVector<float>& y,
-                          const QString& name, const QPen& pen, bool isLineSeries)
+// Helper to create an empty persistent series attached to both axes
+QXYSeries* LiveChartWidget::createSeries(const QString& name, const QPen& pen, bool isLineSeries)
 {
-    QXYSeries* series;
+    QXYSeries* s;
     if (isLineSeries)
-        series = new QLineSeries();
+        s = new QLineSeries();
     else
-        series = new QScatterSeries();
-
-    series->setName(name);
-    series->setPen(pen);
-    for (int i = 0; i < x.size() && i < y.size(); ++i) {
-        series->append(x[i], y[i]);
-    }
-    return series;
+        s = new QScatterSeries();
+
+    s->setName(name);
+    s->setPen(pen);
+    chart->addSeries(s);
+    s->attachAxis(axisX);
+    s->attachAxis(axisY);
+    return s;
 }
 
 void LiveChartWidget::updateChart() {
     if (!reader) return;
 
-    // Snapshot data
-    auto freq = reader->device1Data(FREQ);
-    auto amp1 = reader->device1Data(AMP);
-    auto amp2 = reader->device2Data(AMP);
-    auto amp = divideVectors(amp1, amp2);
-
-    if (freq.size() < 3 || amp.size() < 3) return;
-
-    // Filter by frequency range
-    std::vector<float> xf, yf;
-    for (size_t i = 0; i < freq.size(); ++i) {
-        if (freq[i] >= start_freq && freq[i] <= end_freq) {
-            xf.push_back(freq[i]);
-            yf.push_back(amp[i]);
-        }
-    }
-    if (xf.size() < 3) return;
-
-    std::vector<float> fitX, fitY;
-    bool ok = false;
-
-    if (m_use_approximation) {
-        if (!fitData(xf, yf, fitX, fitY)) return;
-        ok = calculateHalfPowerBandwidth(fitX, fitY, f1, f2, lossFactor);
-        refreshChart(xf, yf, fitX, fitY, ok);
-    } else {
-        ok = calculateHalfPowerBandwidth(xf, yf, f1, f2, lossFactor);
-        refreshChart(xf, yf, {}, {}, ok);
-    }
+    // Pull samples published by the acquisition thread
+    reader->collectSamples();
+
+    // Only frames recorded since the last tick are processed
+    FrameSnapshot frames = reader->frames();
+    series.update(frames);
+    worker->submit(frames, start_freq, end_freq, m_use_approximation);
 
-    m_is_success = ok;
+    if (series.size() < 3) return;
+
+    // Markers and fit come from the latest analysis result
+    refreshChart(m_is_success);
 }
 
+void LiveChartWidget::applyAnalysis(const AnalysisResult &result)
+{
+    // Results for a previous sweep, range or mode are stale
+    if (result.fmin != start_freq || result.fmax != end_freq ||
+        result.usedFit != m_use_approximation ||
+        (reader && result.generation != reader->frames().generation()))
+        return;
 
-std::vector<float> LiveChartWidget::divideVectors(const std::vector<float>& a, const std::vector<float>& b) {
-    size_t minSize = std::min(a.size(), b.size());
-    std::vector<float> result(minSize);
+    if (result.usedFit && result.fitX.empty()) return;
 
-    for (size_t i = 0; i < minSize; ++i) {
-        float ai = i < a.size() ? a[i] : 0.0;  // or any default
-        float bi = i < b.size() ? b[i] : 1.0;  // avoid zero!
+    m_is_success = result.hp.ok;
+    if (result.hp.ok) applyResult(result.hp);
+    m_fitX = result.fitX;
+    m_fitY = result.fitY;
+    m_fitDirty = true;
+}
 
-        result[i] = bi != 0 ? ai / bi : 0.0;
-    }
 
-    return result;
+template <typename Fn>
+static std::vector<float> frameColumn(ModbusReader *reader, Fn value)
+{
+    std::vector<float> column;
+    if (!reader) return column;
+    reader->collectSamples();
+    FrameSnapshot frames = reader->frames();
+    column.reserve(frames.size());
+    frames.forEach(0, [&](const AlignedFrame &fr) { column.push_back(value(fr)); });
+    return column;
 }
 
-QImage LiveChartWidget::getScreenShot()
+std::vector<float> LiveChartWidget::getXData()
 {
-    // Render chart to pixmap
-    QPixmap pixmap(chartView->size());
-    pixmap.fill(Qt::white);
+    return frameColumn(reader, [](const AlignedFrame &fr) { return fr.freq; });
+}
 
-    QPainter painter(&pixmap);
+std::vector<float> LiveChartWidget::getYData1()
+{
+    return frameColumn(reader, [](const AlignedFrame &fr) { return fr.amp1; });
+}
 
-    chartView->render(&painter);
+std::vector<float> LiveChartWidget::getYData2()
+{
+    return frameColumn(reader, [](const AlignedFrame &fr) { return fr.amp2; });
+}
 
-    painter.end();
+std::vector<float> LiveChartWidget::getYData()
+{
+    return frameColumn(reader, [](const AlignedFrame &fr) { return fr.ratio(); });
+}
 
-    // Convert to QByteArray (PNG)
-    QByteArray imageBytes;
-    QBuffer buffer(&imageBytes);
-    buffer.open(QIODevice::WriteOnly);
+FrameSnapshot LiveChartWidget::getFrames()
+{
+    if (!reader) return FrameSnapshot();
+    reader->collectSamples();
+    return reader->frames();
+}
 
-    pixmap.toImage().save(&buffer, "PNG");
+QImage LiveChartWidget::getScreenShot(qreal scale)
+{
+    // Render the chart straight into an image; at scale > 1 the chart is
+    // drawn at that many pixels per widget pixel instead of being upscaled
+    QImage image(chartView->size() * scale, QImage::Format_RGB32);
+    image.setDevicePixelRatio(scale);
+    image.fill(Qt::white);
 
-    // Insert into sheet
-    QImage img = QImage::fromData(imageBytes, "PNG");
-    return img;
+    QPainter painter(&image);
+    chartView->render(&painter);
+    painter.end();
 
+    return image;
 }
 
 void  LiveChartWidget::useApproximation(bool isUse)
 {
     m_use_approximation = isUse;
+    m_fitDirty = true;
     this->updateChart();
 }
 
 
-// Unified half-power calculation (used by both fit and raw modes)
-bool LiveChartWidget::calculateHalfPowerBandwidth(
-    const std::vector<float>& freq,
-    const std::vector<float>& amp,
-    float &f1, float &f2, float &lossFactor)
+void LiveChartWidget::applyResult(const HalfPowerResult &hp)
 {
-    if (freq.size() < 3 || amp.size() < 3) return false;
-
-    // Find peak
-    auto maxIt = std::max_element(amp.begin(), amp.end());
-    float peakAmp = *maxIt;
-    int idx = std::distance(amp.begin(), maxIt);
-    float peakFreq = freq[idx];
-    float threshold = peakAmp / std::sqrt(2.0);
-
-    f1 = -1; f2 = -1;
-
-    // Lower crossing
-    for (int i = idx; i > 0; --i) {
-        if (amp[i] > threshold && amp[i - 1] <= threshold) {
-            float t = (threshold - amp[i]) / (amp[i - 1] - amp[i]);
-            f1 = freq[i] + t * (freq[i - 1] - freq[i]);
-            break;
-        }
-    }
-
-    // Upper crossing
-    for (int i = idx; i < (int)freq.size() - 1; ++i) {
-        if (amp[i] > threshold && amp[i + 1] <= threshold) {
-            float t = (threshold - amp[i]) / (amp[i + 1] - amp[i]);
-            f2 = freq[i] + t * (freq[i + 1] - freq[i]);
-            break;
-        }
-    }
-
-    if (f1 < 0 || f2 < 0) return false;
-
-    lossFactor = (f2 - f1) / peakFreq;
-    this->peakFreq = peakFreq;
-    this->lossFactor = lossFactor;
-    this->f1 = f1;
-    this->f2 = f2;
-    this->peakAmplitude = peakAmp;
-    this->threshold = threshold;
-    this->deltaF = f2 - f1;
-
-    return true;
+    this->peakFreq = hp.peakFreq;
+    this->lossFactor = hp.lossFactor;
+    this->f1 = hp.f1;
+    this->f2 = hp.f2;
+    this->peakAmplitude = hp.peakAmplitude;
+    this->threshold = hp.threshold;
+    this->deltaF = hp.deltaF;
 }
 
 
-// Safe chart refresh: clears series/axes properly
-void LiveChartWidget::refreshChart(const std::vector<float>& x,
-                                   const std::vector<float>& y,
-                                   const std::vector<float>& fitX,
-                                   const std::vector<float>& fitY,
-                                   const bool status)
+// Incremental chart refresh: series are persistent, raw points are appended
+// as deltas (or, past two points per pixel column, replaced by the min/max
+// decimation) and only the small fit/marker series are replaced.
+void LiveChartWidget::refreshChart(const bool status)
 {
-    chart->removeAllSeries();
-
-    auto addSeries = [&] (QVector<float> x, QVector<float> y, QString name, QPen pen, bool isLineSeries=true)
-    {
-        auto new_series = createSeries(x, y, name, pen, isLineSeries);
-        chart->addSeries(new_series);
-        new_series->attachAxis(axisX);
-        new_series->attachAxis(axisY);
-        return new_series;
-    };
-
-    addSeries(QVector<float>(x.begin(), x.end()),
-              QVector<float>(y.begin(), y.end()), "Raw", QPen(QColorConstants::Blue, 2), !m_use_approximation)->setMarkerSize(5);
-
-    if (!fitX.empty() && !fitY.empty()) {
-        addSeries(QVector<float>(fitX.begin(), fitX.end()),
-                  QVector<float>(fitY.begin(), fitY.end()), "Fit", QPen(QColorConstants::Blue, 2));
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    const auto &x = series.x();
+    const auto &y = series.y();
+
+    QXYSeries *raw = m_use_approximation ? static_cast<QXYSeries*>(rawScatter) : rawLine;
+    QXYSeries *hidden = m_use_approximation ? static_cast<QXYSeries*>(rawLine) : rawScatter;
+
+    int columns = int(chart->plotArea().width());
+    if (columns <= 0) columns = chartView->width();
+    bool decimate = x.size() > size_t(2 * columns);
+
+    bool redraw = m_drawnEpoch != series.epoch() || raw != m_drawnRaw || m_drawnCount > x.size();
+    if (redraw) {
+        // new recording, range or display mode: redraw from scratch once
+        hidden->clear();
+        hidden->setVisible(false);
+        raw->setVisible(true);
+        m_drawnRaw = raw;
+        m_drawnEpoch = series.epoch();
+        m_drawnCount = 0;
+        m_yMax = 0;
+    }
 
+    if (decimate) {
+        // Drawing cost bounded by the widget width, not the recording length
+        decimator.setView(start_freq, end_freq, columns);
+        if (decimator.update(x, y, series.epoch()) || redraw || !m_drawnDecimated)
+            raw->replace(toPoints(decimator.x(), decimator.y(), 0));
+    } else if (redraw || m_drawnDecimated) {
+        raw->replace(toPoints(x, y, 0));
+    } else if (m_drawnCount < x.size()) {
+        raw->append(toPoints(x, y, m_drawnCount));
+    }
+    m_drawnDecimated = decimate;
+    for (size_t i = m_drawnCount; i < y.size(); ++i)
+        m_yMax = std::max(m_yMax, y[i]);
+    m_drawnCount = x.size();
+
+    if (m_fitDirty) {
+        if (m_use_approximation)
+            fitSeries->replace(toPoints(m_fitX, m_fitY, 0));
+        else
+            fitSeries->clear();
+        m_fitDirty = false;
     }
+    fitSeries->setVisible(m_use_approximation && fitSeries->count() > 0);
 
     float y_min = 0;
-    float y_max = ceil( *std::max_element(y.begin(), y.end() ));
+    float y_max = ceil(m_yMax);
 
     if (status)
     {
-
         // Half-power line
-        QVector<float> hp_x = { this->f1, this->f2 };
-        QVector<float> hp_y = { this->threshold,  this->threshold };
+        thresholdLine->replace({ QPointF(this->f1, this->threshold), QPointF(this->f2, this->threshold) });
 
         // Vertical markers
-        QVector<float> vxf1 = { this->f1, this->f1 };
-        QVector<float> vxf2 = { this->f2, this->f2 };
-        QVector<float> vxf = { this->peakFreq, this->peakFreq };
-        QVector<float> vyf = { y_min, y_max };
-
-        addSeries(hp_x, hp_y, "Threshold", QPen(QColorConstants::Green));
-        addSeries(vxf1, vyf, "f1", QPen(QColorConstants::Red));
-        addSeries(vxf2, vyf, "f2", QPen(QColorConstants::Red));
-        addSeries(vxf, vyf, "f_peak", QPen(QColorConstants::Gray));
+        f1Line->replace({ QPointF(this->f1, y_min), QPointF(this->f1, y_max) });
+        f2Line->replace({ QPointF(this->f2, y_min), QPointF(this->f2, y_max) });
+        peakLine->replace({ QPointF(this->peakFreq, y_min), QPointF(this->peakFreq, y_max) });
     }
+    for (QXYSeries *marker : { thresholdLine, f1Line, f2Line, peakLine })
+        marker->setVisible(status);
 
     axisX->setRange(start_freq, end_freq);
     axisY->setRange(y_min, y_max);
+
+    // Frame-time budget for the chart path (excluding the deferred paint)
+    const qint64 ns = frameTimer.nsecsElapsed();
+    m_refreshMetric.record(ns);
+    double ms = ns / 1e6;
+    m_refreshMs = m_refreshMs == 0 ? ms : 0.9 * m_refreshMs + 0.1 * ms;
+    m_refreshMaxMs = std::max(m_refreshMaxMs, ms);
+    if (ms > ChartFrameBudgetMs)
+        m_overBudgetMetric.add();
+    if (ms > ChartFrameBudgetMs && (!m_budgetWarned.isValid() || m_budgetWarned.elapsed() > 5000)) {
+        qCWarning(lcChart) << "Chart refresh took" << ms << "ms, budget" << ChartFrameBudgetMs << "ms,"
+                   << x.size() << "points";
+        m_budgetWarned.start();
+    }
+}
+
+QList<QPointF> LiveChartWidget::toPoints(const std::vector<float>& x, const std::vector<float>& y, size_t from)
+{
+    QList<QPointF> points;
+    size_t n = std::min(x.size(), y.size());
+    if (from >= n) return points;
+    points.reserve(n - from);
+    for (size_t i = from; i < n; ++i)
+        points.append(QPointF(x[i], y[i]));
+    return points;
 }
@@ -4,7 +4,12 @@
 #include <QWidget>
 #include <QtCharts>
 #include <QTimer>
+#include <QElapsedTimer>
 #include "modbusreader.h"  // needed to access your vectors
+#include "resonanceanalyzer.h"
+#include "analysisworker.h"
+#include "chartdecimator.h"
+#include "metrics.h"
 
 //QT_CHARTS_USE_NAMESPACE
 
@@ -13,7 +18,9 @@ class LiveChartWidget : public QWidget {
 
 public:
     LiveChartWidget(ModbusReader* reader, QWidget *parent = nullptr);
-    QImage getScreenShot();
+    ~LiveChartWidget();
+    // Chart as shown, rendered at scale device pixels per widget pixel
+    QImage getScreenShot(qreal scale = 1.0);
 
     double getPeakFreq() {return peakFreq;}
     double getdeltaF() {return deltaF;}
@@ -24,25 +31,31 @@ public:
     double getf1() {return f1;}
     double getf2() {return f2;}
 
-    std::vector<float> getXData()  { return reader ? reader->device1Data(FREQ) : std::vector<float>(0); }
-    std::vector<float> getYData1() { return reader ? reader->device1Data(AMP)  : std::vector<float>(0); }
-    std::vector<float> getYData2() { return reader ? reader->device2Data(AMP) : std::vector<float>(0); }
-    std::vector<float> getYData()  { return divideVectors(getYData1(), getYData2()); }
+    // Smoothed and worst chart refresh time in ms
+    double chartRefreshMs() const { return m_refreshMs; }
+    double chartRefreshMaxMs() const { return m_refreshMaxMs; }
+
+    // Columns of the time-aligned frames (frequency, sensor 1, sensor 2, ratio)
+    std::vector<float> getXData();
+    std::vector<float> getYData1();
+    std::vector<float> getYData2();
+    std::vector<float> getYData();
+    // All frames recorded so far, as one immutable snapshot
+    FrameSnapshot getFrames();
 
 
     void setFreqInterval(qreal start_freq, qreal end_freq);
     void useApproximation(bool isUse);
 private slots:
     void updateChart();
+    void applyAnalysis(const AnalysisResult &result);
 
 private:
     QChart *chart;
-    QLineSeries *series;
     QChartView *chartView;
     QTimer *updateTimer;
     ModbusReader* reader;
     void addVerticalLine(QChart* chart, qreal x, qreal minY, qreal maxY, QColor color = Qt::red, int thickness = 3);
-    std::vector<float> divideVectors(const std::vector<float>& a, const std::vector<float>& b);
     bool computeLossFactorOberst(const std::vector<float>& xData, const std::vector<float>& yData);
     float peakFreq;
     float deltaF;
@@ -50,7 +63,7 @@ private:
     float peakAmplitude;
     float threshold;
     float f1, f2;
-    bool m_is_success;
+    bool m_is_success = false;
     bool m_use_approximation;
     float start_freq = 0, end_freq = 1000;
     QList<QLineSeries*> verticalLines;
@@ -63,13 +76,8 @@ private:
 
     void removeVerticalLines();
 
-    bool fitData(const std::vector<float>& frequencies,
-                 const std::vector<float>& amplitudes,
-                 std::vector<float>& fitX,
-                 std::vector<float>& fitY);
-
-    QXYSeries* createSeries(const QVector<float>& x, const QVector<float>& y,
-                            const QString& name, const QPen& pen = QPen(Qt::SolidLine), bool isLineSeris = true);
+    QXYSeries* createSeries(const QString& name, const QPen& pen = QPen(Qt::SolidLine), bool isLineSeris = true);
+    static QList<QPointF> toPoints(const std::vector<float>& x, const std::vector<float>& y, size_t from);
     QChartView* createResonanceChart(
         const std::vector<float>& frequencies,
         const std::vector<float>& amplitudes,
@@ -82,14 +90,33 @@ private:
 
     QValueAxis *axisX;
     QValueAxis *axisY;
-    void refreshChart(const std::vector<float>& x,
-                      const std::vector<float>& y,
-                      const std::vector<float>& fitX = {},
-                      const std::vector<float>& fitY = {},
-                      const bool status = false);
-    bool calculateHalfPowerBandwidth(const std::vector<float>& freq,
-                                     const std::vector<float>& amp,
-                                     float &f1, float &f2, float &lossFactor);
+    void refreshChart(const bool status = false);
+
+    // Persistent series (created once, updated in place)
+    QLineSeries *rawLine;
+    QScatterSeries *rawScatter;
+    QXYSeries *fitSeries;
+    QXYSeries *thresholdLine, *f1Line, *f2Line, *peakLine;
+    QXYSeries *m_drawnRaw = nullptr;     // raw series currently showing data
+    std::uint64_t m_drawnEpoch = 0;      // RangeFilteredSeries::epoch() drawn
+    size_t m_drawnCount = 0;             // raw points already in the series
+    bool m_drawnDecimated = false;       // raw series shows the decimated data
+    MinMaxDecimator decimator;
+    float m_yMax = 0;
+    bool m_fitDirty = false;
+
+    // Chart path timing
+    static constexpr double ChartFrameBudgetMs = 20.0;
+    double m_refreshMs = 0, m_refreshMaxMs = 0;
+    QElapsedTimer m_budgetWarned;
+    Histogram &m_refreshMetric = Metrics::instance().histogram("chart.refresh");
+    Counter &m_overBudgetMetric = Metrics::instance().counter("chart.over_budget");
+
+    RangeFilteredSeries series;          // raw in-range points for drawing
+    QThread *analysisThread;
+    AnalysisWorker *worker;
+    std::vector<float> m_fitX, m_fitY;   // fit curve of the latest result
+    void applyResult(const HalfPowerResult &hp);
 
 };
 
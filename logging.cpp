@@ -0,0 +1,26 @@
+#include "logging.h"
+#include <chrono>
+#include "metrics.h"
+
+Q_LOGGING_CATEGORY(lcModbus, "lfa.modbus", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcAcquisition, "lfa.acquisition", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcChart, "lfa.chart", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcExport, "lfa.export", QtInfoMsg)
+
+LogRateLimiter::LogRateLimiter(qint64 intervalMs)
+    : m_intervalNs(intervalMs * 1000000)
+    , m_suppressed(Metrics::instance().counter("log.suppressed"))
+{
+}
+
+bool LogRateLimiter::allow() {
+    const qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count();
+    qint64 next = m_nextNs.load(std::memory_order_relaxed);
+    // Only one of several threads racing for the same slot wins it
+    if (now >= next && m_nextNs.compare_exchange_strong(next, now + m_intervalNs, std::memory_order_relaxed))
+        return true;
+    m_suppressed.add();
+    return false;
+}
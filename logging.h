@@ -0,0 +1,45 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#pragma once
+
+#include <QLoggingCategory>
+#include <QtGlobal>
+#include <atomic>
+
+// Logging categories of the application. Debug output is off by default and
+// a disabled qCDebug() costs one flag test, its arguments are not evaluated.
+// Enable with QT_LOGGING_RULES, e.g. "lfa.*.debug=true" or
+// "lfa.acquisition.debug=true".
+Q_DECLARE_LOGGING_CATEGORY(lcModbus)        // bus setup, poll timing, write errors
+Q_DECLARE_LOGGING_CATEGORY(lcAcquisition)   // per-reading values and flags
+Q_DECLARE_LOGGING_CATEGORY(lcChart)
+Q_DECLARE_LOGGING_CATEGORY(lcExport)
+
+class Counter;
+
+// Lets at most one message through per interval. Messages held back are
+// counted in the "log.suppressed" metric. Thread-safe.
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(qint64 intervalMs);
+    bool allow();
+
+private:
+    const qint64 m_intervalNs;
+    std::atomic<qint64> m_nextNs{0};
+    Counter &m_suppressed;
+};
+
+// qCDebug() for per-reading messages: one per intervalMs at most from each
+// call site, nothing evaluated while the category's debug output is off.
+//   qCDebugLimited(lcAcquisition, 1000) << "flags:" << flags;
+#define qCDebugLimited(category, intervalMs)                                                  \
+    for (bool lfaLog_ = category().isDebugEnabled() && []() {                                 \
+             static LogRateLimiter limiter(intervalMs);                                      \
+             return limiter.allow();                                                          \
+         }();                                                                                 \
+         lfaLog_; lfaLog_ = false)                                                            \
+        qCDebug(category)
+
+#endif // LOGGING_H
@@ -0,0 +1,441 @@
+#include "lorentzian_kernels.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LFA_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// SSE2 is part of the x86-64 baseline; on 32-bit x86 only when enabled
+#if defined(LFA_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LFA_HAVE_SSE2 1
+#endif
+
+// AVX2 code is compiled per function so the rest of the program keeps the
+// baseline instruction set and still runs on older CPUs.
+#if defined(LFA_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LFA_HAVE_AVX2 1
+#define LFA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#elif defined(LFA_X86) && defined(_MSC_VER)
+#define LFA_HAVE_AVX2 1
+#define LFA_TARGET_AVX2
+#endif
+
+namespace {
+
+// Per-point model terms shared by the scalar paths and the SIMD tails
+struct Consts {
+    double A0, f0, alpha, off;
+    double invf0, inveta2, cF0, cEta;
+
+    explicit Consts(const double p[5])
+        : A0(p[0]), f0(p[1]), alpha(p[3]), off(p[4]),
+          invf0(1.0 / p[1]), inveta2(1.0 / (p[2] * p[2])),
+          cF0(-1.0 / (p[1] * p[1])), cEta(2.0 / (p[2] * p[2] * p[2])) {}
+};
+
+inline double model1(const Consts &c, double x)
+{
+    const double u = (x - c.f0) * c.invf0;
+    const double L = 1.0 / (1.0 + u * u * c.inveta2);
+    return c.A0 * L * (1.0 + c.alpha * u) + c.off;
+}
+
+inline double gradient1(const Consts &c, double x, double g[5])
+{
+    const double u = (x - c.f0) * c.invf0;
+    const double u2 = u * u;
+    const double L = 1.0 / (1.0 + u2 * c.inveta2);
+    const double S = 1.0 + c.alpha * u;
+    const double LS = L * S;
+    const double dL_du = -2.0 * u * c.inveta2 * L * L;
+    const double dy_du = c.A0 * (dL_du * S + L * c.alpha);
+
+    g[0] = LS;
+    g[1] = dy_du * x * c.cF0;
+    g[2] = c.A0 * S * u2 * L * L * c.cEta;
+    g[3] = c.A0 * L * u;
+    g[4] = 1.0;
+    return c.A0 * LS + c.off;
+}
+
+// Upper triangle of J^T J packed row by row: (0,0) (0,1) .. (0,4) (1,1) ..
+inline void unpack(const double packed[15], double JTJ[5][5])
+{
+    int k = 0;
+    for (int a = 0; a < 5; ++a)
+        for (int b = a; b < 5; ++b) {
+            JTJ[a][b] = packed[k];
+            JTJ[b][a] = packed[k];
+            ++k;
+        }
+}
+
+// ---------- Scalar ----------
+
+double sse_scalar(const float *x, const float *y, std::size_t n, const double p[5])
+{
+    const Consts c(p);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double d = y[i] - model1(c, x[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+void eval_scalar(const float *x, const float *y, std::size_t n, const double p[5], float *out)
+{
+    const Consts c(p);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double m = model1(c, x[i]);
+        out[i] = float(y ? y[i] - m : m);
+    }
+}
+
+double normal_scalar_range(const Consts &c, const float *x, const float *y, std::size_t begin, std::size_t n,
+                           double packed[15], double JTr[5])
+{
+    double sum = 0.0;
+    double g[5];
+    for (std::size_t i = begin; i < n; ++i) {
+        const double r = y[i] - gradient1(c, x[i], g);
+        int k = 0;
+        for (int a = 0; a < 5; ++a) {
+            JTr[a] += g[a] * r;
+            for (int b = a; b < 5; ++b) packed[k++] += g[a] * g[b];
+        }
+        sum += r * r;
+    }
+    return sum;
+}
+
+double normal_scalar(const float *x, const float *y, std::size_t n, const double p[5],
+                     double JTJ[5][5], double JTr[5])
+{
+    const Consts c(p);
+    double packed[15] = {0};
+    for (int a = 0; a < 5; ++a) JTr[a] = 0.0;
+    double sum = normal_scalar_range(c, x, y, 0, n, packed, JTr);
+    unpack(packed, JTJ);
+    return sum;
+}
+
+// ---------- SSE2 (2 x double) ----------
+
+#ifdef LFA_HAVE_SSE2
+
+inline double hsum_sse2(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+inline __m128d load2_sse2(const float *p)
+{
+    return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(p))));
+}
+
+double sse_sse2(const float *x, const float *y, std::size_t n, const double p[5])
+{
+    const Consts c(p);
+    const __m128d one = _mm_set1_pd(1.0), A0 = _mm_set1_pd(c.A0), f0 = _mm_set1_pd(c.f0),
+                  alpha = _mm_set1_pd(c.alpha), off = _mm_set1_pd(c.off),
+                  invf0 = _mm_set1_pd(c.invf0), inveta2 = _mm_set1_pd(c.inveta2);
+    __m128d acc = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d xv = load2_sse2(x + i), yv = load2_sse2(y + i);
+        const __m128d u = _mm_mul_pd(_mm_sub_pd(xv, f0), invf0);
+        const __m128d L = _mm_div_pd(one, _mm_add_pd(one, _mm_mul_pd(_mm_mul_pd(u, u), inveta2)));
+        const __m128d S = _mm_add_pd(one, _mm_mul_pd(alpha, u));
+        const __m128d d = _mm_sub_pd(yv, _mm_add_pd(_mm_mul_pd(A0, _mm_mul_pd(L, S)), off));
+        acc = _mm_add_pd(acc, _mm_mul_pd(d, d));
+    }
+    double sum = hsum_sse2(acc);
+    for (; i < n; ++i) {
+        const double d = y[i] - model1(c, x[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+void eval_sse2(const float *x, const float *y, std::size_t n, const double p[5], float *out)
+{
+    const Consts c(p);
+    const __m128d one = _mm_set1_pd(1.0), A0 = _mm_set1_pd(c.A0), f0 = _mm_set1_pd(c.f0),
+                  alpha = _mm_set1_pd(c.alpha), off = _mm_set1_pd(c.off),
+                  invf0 = _mm_set1_pd(c.invf0), inveta2 = _mm_set1_pd(c.inveta2);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d xv = load2_sse2(x + i);
+        const __m128d u = _mm_mul_pd(_mm_sub_pd(xv, f0), invf0);
+        const __m128d L = _mm_div_pd(one, _mm_add_pd(one, _mm_mul_pd(_mm_mul_pd(u, u), inveta2)));
+        const __m128d S = _mm_add_pd(one, _mm_mul_pd(alpha, u));
+        __m128d m = _mm_add_pd(_mm_mul_pd(A0, _mm_mul_pd(L, S)), off);
+        if (y) m = _mm_sub_pd(load2_sse2(y + i), m);
+        _mm_store_sd(reinterpret_cast<double *>(out + i), _mm_castps_pd(_mm_cvtpd_ps(m)));
+    }
+    for (; i < n; ++i) {
+        const double m = model1(c, x[i]);
+        out[i] = float(y ? y[i] - m : m);
+    }
+}
+
+double normal_sse2(const float *x, const float *y, std::size_t n, const double p[5],
+                   double JTJ[5][5], double JTr[5])
+{
+    const Consts c(p);
+    const __m128d one = _mm_set1_pd(1.0), A0 = _mm_set1_pd(c.A0), f0 = _mm_set1_pd(c.f0),
+                  alpha = _mm_set1_pd(c.alpha), off = _mm_set1_pd(c.off),
+                  invf0 = _mm_set1_pd(c.invf0), inveta2 = _mm_set1_pd(c.inveta2),
+                  cF0 = _mm_set1_pd(c.cF0), cEta = _mm_set1_pd(c.cEta), m2 = _mm_set1_pd(-2.0);
+
+    __m128d acc[15], accr[5], accs = _mm_setzero_pd();
+    for (auto &a : acc) a = _mm_setzero_pd();
+    for (auto &a : accr) a = _mm_setzero_pd();
+
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d xv = load2_sse2(x + i), yv = load2_sse2(y + i);
+        const __m128d u = _mm_mul_pd(_mm_sub_pd(xv, f0), invf0);
+        const __m128d u2 = _mm_mul_pd(u, u);
+        const __m128d L = _mm_div_pd(one, _mm_add_pd(one, _mm_mul_pd(u2, inveta2)));
+        const __m128d L2 = _mm_mul_pd(L, L);
+        const __m128d S = _mm_add_pd(one, _mm_mul_pd(alpha, u));
+        const __m128d LS = _mm_mul_pd(L, S);
+        const __m128d dL_du = _mm_mul_pd(_mm_mul_pd(m2, _mm_mul_pd(u, inveta2)), L2);
+        const __m128d dy_du = _mm_mul_pd(A0, _mm_add_pd(_mm_mul_pd(dL_du, S), _mm_mul_pd(L, alpha)));
+
+        __m128d g[5];
+        g[0] = LS;
+        g[1] = _mm_mul_pd(_mm_mul_pd(dy_du, xv), cF0);
+        g[2] = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(A0, S), _mm_mul_pd(u2, L2)), cEta);
+        g[3] = _mm_mul_pd(_mm_mul_pd(A0, L), u);
+        g[4] = one;
+        const __m128d r = _mm_sub_pd(yv, _mm_add_pd(_mm_mul_pd(A0, LS), off));
+
+        int k = 0;
+        for (int a = 0; a < 5; ++a) {
+            accr[a] = _mm_add_pd(accr[a], _mm_mul_pd(g[a], r));
+            for (int b = a; b < 5; ++b, ++k)
+                acc[k] = _mm_add_pd(acc[k], _mm_mul_pd(g[a], g[b]));
+        }
+        accs = _mm_add_pd(accs, _mm_mul_pd(r, r));
+    }
+
+    double packed[15];
+    for (int k = 0; k < 15; ++k) packed[k] = hsum_sse2(acc[k]);
+    for (int a = 0; a < 5; ++a) JTr[a] = hsum_sse2(accr[a]);
+    double sum = hsum_sse2(accs) + normal_scalar_range(c, x, y, i, n, packed, JTr);
+    unpack(packed, JTJ);
+    return sum;
+}
+
+#endif // LFA_HAVE_SSE2
+
+// ---------- AVX2 + FMA (4 x double) ----------
+
+#ifdef LFA_HAVE_AVX2
+
+LFA_TARGET_AVX2 inline double hsum_avx2(__m256d v)
+{
+    const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+LFA_TARGET_AVX2 double sse_avx2(const float *x, const float *y, std::size_t n, const double p[5])
+{
+    const Consts c(p);
+    const __m256d one = _mm256_set1_pd(1.0), A0 = _mm256_set1_pd(c.A0), f0 = _mm256_set1_pd(c.f0),
+                  alpha = _mm256_set1_pd(c.alpha), off = _mm256_set1_pd(c.off),
+                  invf0 = _mm256_set1_pd(c.invf0), inveta2 = _mm256_set1_pd(c.inveta2);
+    __m256d acc = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d xv = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+        const __m256d yv = _mm256_cvtps_pd(_mm_loadu_ps(y + i));
+        const __m256d u = _mm256_mul_pd(_mm256_sub_pd(xv, f0), invf0);
+        const __m256d L = _mm256_div_pd(one, _mm256_fmadd_pd(_mm256_mul_pd(u, u), inveta2, one));
+        const __m256d S = _mm256_fmadd_pd(alpha, u, one);
+        const __m256d d = _mm256_sub_pd(yv, _mm256_fmadd_pd(A0, _mm256_mul_pd(L, S), off));
+        acc = _mm256_fmadd_pd(d, d, acc);
+    }
+    double sum = hsum_avx2(acc);
+    for (; i < n; ++i) {
+        const double d = y[i] - model1(c, x[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+LFA_TARGET_AVX2 void eval_avx2(const float *x, const float *y, std::size_t n, const double p[5], float *out)
+{
+    const Consts c(p);
+    const __m256d one = _mm256_set1_pd(1.0), A0 = _mm256_set1_pd(c.A0), f0 = _mm256_set1_pd(c.f0),
+                  alpha = _mm256_set1_pd(c.alpha), off = _mm256_set1_pd(c.off),
+                  invf0 = _mm256_set1_pd(c.invf0), inveta2 = _mm256_set1_pd(c.inveta2);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d xv = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+        const __m256d u = _mm256_mul_pd(_mm256_sub_pd(xv, f0), invf0);
+        const __m256d L = _mm256_div_pd(one, _mm256_fmadd_pd(_mm256_mul_pd(u, u), inveta2, one));
+        const __m256d S = _mm256_fmadd_pd(alpha, u, one);
+        __m256d m = _mm256_fmadd_pd(A0, _mm256_mul_pd(L, S), off);
+        if (y) m = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(y + i)), m);
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(m));
+    }
+    for (; i < n; ++i) {
+        const double m = model1(c, x[i]);
+        out[i] = float(y ? y[i] - m : m);
+    }
+}
+
+LFA_TARGET_AVX2 double normal_avx2(const float *x, const float *y, std::size_t n, const double p[5],
+                                   double JTJ[5][5], double JTr[5])
+{
+    const Consts c(p);
+    const __m256d one = _mm256_set1_pd(1.0), A0 = _mm256_set1_pd(c.A0), f0 = _mm256_set1_pd(c.f0),
+                  alpha = _mm256_set1_pd(c.alpha), off = _mm256_set1_pd(c.off),
+                  invf0 = _mm256_set1_pd(c.invf0), inveta2 = _mm256_set1_pd(c.inveta2),
+                  cF0 = _mm256_set1_pd(c.cF0), cEta = _mm256_set1_pd(c.cEta), m2 = _mm256_set1_pd(-2.0);
+
+    __m256d acc[15], accr[5], accs = _mm256_setzero_pd();
+    for (auto &a : acc) a = _mm256_setzero_pd();
+    for (auto &a : accr) a = _mm256_setzero_pd();
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d xv = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+        const __m256d yv = _mm256_cvtps_pd(_mm_loadu_ps(y + i));
+        const __m256d u = _mm256_mul_pd(_mm256_sub_pd(xv, f0), invf0);
+        const __m256d u2 = _mm256_mul_pd(u, u);
+        const __m256d L = _mm256_div_pd(one, _mm256_fmadd_pd(u2, inveta2, one));
+        const __m256d L2 = _mm256_mul_pd(L, L);
+        const __m256d S = _mm256_fmadd_pd(alpha, u, one);
+        const __m256d LS = _mm256_mul_pd(L, S);
+        const __m256d dL_du = _mm256_mul_pd(_mm256_mul_pd(m2, _mm256_mul_pd(u, inveta2)), L2);
+        const __m256d dy_du = _mm256_mul_pd(A0, _mm256_fmadd_pd(dL_du, S, _mm256_mul_pd(L, alpha)));
+
+        __m256d g[5];
+        g[0] = LS;
+        g[1] = _mm256_mul_pd(_mm256_mul_pd(dy_du, xv), cF0);
+        g[2] = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(A0, S), _mm256_mul_pd(u2, L2)), cEta);
+        g[3] = _mm256_mul_pd(_mm256_mul_pd(A0, L), u);
+        g[4] = one;
+        const __m256d r = _mm256_sub_pd(yv, _mm256_fmadd_pd(A0, LS, off));
+
+        int k = 0;
+        for (int a = 0; a < 5; ++a) {
+            accr[a] = _mm256_fmadd_pd(g[a], r, accr[a]);
+            for (int b = a; b < 5; ++b, ++k)
+                acc[k] = _mm256_fmadd_pd(g[a], g[b], acc[k]);
+        }
+        accs = _mm256_fmadd_pd(r, r, accs);
+    }
+
+    double packed[15];
+    for (int k = 0; k < 15; ++k) packed[k] = hsum_avx2(acc[k]);
+    for (int a = 0; a < 5; ++a) JTr[a] = hsum_avx2(accr[a]);
+    double sum = hsum_avx2(accs) + normal_scalar_range(c, x, y, i, n, packed, JTr);
+    unpack(packed, JTJ);
+    return sum;
+}
+
+#endif // LFA_HAVE_AVX2
+
+// ---------- Dispatch ----------
+
+LorentzianIsa detectIsa()
+{
+#ifdef LFA_HAVE_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return LorentzianIsa::AVX2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool fma = info[2] & (1 << 12);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    if (fma && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return LorentzianIsa::AVX2;
+    }
+#endif
+#endif
+#ifdef LFA_HAVE_SSE2
+    return LorentzianIsa::SSE2;
+#else
+    return LorentzianIsa::Scalar;
+#endif
+}
+
+const LorentzianIsa bestIsa = detectIsa();
+std::atomic<LorentzianIsa> activeIsa{bestIsa};
+
+} // namespace
+
+double lorentzian_sse(const float *x, const float *y, std::size_t n, const double p[5])
+{
+    switch (activeIsa.load(std::memory_order_relaxed)) {
+#ifdef LFA_HAVE_AVX2
+    case LorentzianIsa::AVX2: return sse_avx2(x, y, n, p);
+#endif
+#ifdef LFA_HAVE_SSE2
+    case LorentzianIsa::SSE2: return sse_sse2(x, y, n, p);
+#endif
+    default: return sse_scalar(x, y, n, p);
+    }
+}
+
+void lorentzian_eval(const float *x, const float *y, std::size_t n, const double p[5], float *out)
+{
+    switch (activeIsa.load(std::memory_order_relaxed)) {
+#ifdef LFA_HAVE_AVX2
+    case LorentzianIsa::AVX2: eval_avx2(x, y, n, p, out); return;
+#endif
+#ifdef LFA_HAVE_SSE2
+    case LorentzianIsa::SSE2: eval_sse2(x, y, n, p, out); return;
+#endif
+    default: eval_scalar(x, y, n, p, out); return;
+    }
+}
+
+double lorentzian_normal_equations(const float *x, const float *y, std::size_t n, const double p[5],
+                                   double JTJ[5][5], double JTr[5])
+{
+    switch (activeIsa.load(std::memory_order_relaxed)) {
+#ifdef LFA_HAVE_AVX2
+    case LorentzianIsa::AVX2: return normal_avx2(x, y, n, p, JTJ, JTr);
+#endif
+#ifdef LFA_HAVE_SSE2
+    case LorentzianIsa::SSE2: return normal_sse2(x, y, n, p, JTJ, JTr);
+#endif
+    default: return normal_scalar(x, y, n, p, JTJ, JTr);
+    }
+}
+
+LorentzianIsa lorentzian_isa()
+{
+    return activeIsa.load(std::memory_order_relaxed);
+}
+
+void lorentzian_set_isa(LorentzianIsa isa)
+{
+    activeIsa.store(int(isa) <= int(bestIsa) ? isa : bestIsa, std::memory_order_relaxed);
+}
+
+const char *lorentzian_isa_name(LorentzianIsa isa)
+{
+    switch (isa) {
+    case LorentzianIsa::AVX2: return "AVX2+FMA";
+    case LorentzianIsa::SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
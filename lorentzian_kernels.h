@@ -0,0 +1,34 @@
+#ifndef LORENTZIAN_KERNELS_H
+#define LORENTZIAN_KERNELS_H
+
+#pragma once
+
+#include <cstddef>
+
+// Batch kernels for the skewed Lorentzian model over a whole frequency
+// vector. x and y are separate float arrays (structure of arrays), parameters
+// p = {A0, f0, eta, alpha, offset} and all accumulation are double.
+//
+// The implementation is chosen once at runtime: AVX2+FMA (4 points per step),
+// SSE2 (2 points per step) or portable scalar code.
+
+enum class LorentzianIsa { Scalar, SSE2, AVX2 };
+
+// Sum of squared residuals (y - model)^2
+double lorentzian_sse(const float *x, const float *y, std::size_t n, const double p[5]);
+
+// out[i] = model(x[i]), or y[i] - model(x[i]) when y is not null
+void lorentzian_eval(const float *x, const float *y, std::size_t n, const double p[5], float *out);
+
+// Gauss-Newton normal equations in a single pass: JTJ = J^T J, JTr = J^T r
+// with r = y - model and J the model gradient. Returns the SSE at p.
+double lorentzian_normal_equations(const float *x, const float *y, std::size_t n, const double p[5],
+                                   double JTJ[5][5], double JTr[5]);
+
+// Active implementation; lorentzian_set_isa() forces one (clamped to what
+// the CPU supports) for profiling.
+LorentzianIsa lorentzian_isa();
+void lorentzian_set_isa(LorentzianIsa isa);
+const char *lorentzian_isa_name(LorentzianIsa isa);
+
+#endif // LORENTZIAN_KERNELS_H
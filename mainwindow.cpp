@@ -5,11 +5,14 @@
 #include "modbusconfigdialog.h"
 #include "modbusreader.h"
 #include <QTimer>
+#include <QtNumeric>
+#include <QStandardPaths>
 #include "livechartwidget.h"
+#include "exportworker.h"
+#include "diagnosticsdialog.h"
+#include "logging.h"
+#include "metrics.h"
 
-// for export into xslx file
-#include "xlsxdocument.h"
-#include "xlsxworkbook.h"
 using namespace QXlsx;
 
 MainWindow::MainWindow(QWidget *parent)
@@ -46,21 +49,54 @@ MainWindow::MainWindow(QWidget *parent)
 
     this->dlg = new modbusconfigdialog(this);
 
+    QSettings settings;
+
+    // Sweeps are streamed to disk on their own thread, see SweepRecorder
+    recorderThread = new QThread(this);
+    recorderThread->setObjectName("recorder");
+    recorder = new SweepRecorder;
+    recorder->moveToThread(recorderThread);
+    connect(recorderThread, &QThread::finished, recorder, &QObject::deleteLater);
+    connect(recorder, &SweepRecorder::errorOccurred, this, [](const QString &err) {
+        qWarning() << err;
+    });
+    recorderThread->start();
+
     reader = new ModbusReader;
+    reader->setRecorder(recorder);
+
+    // Polling runs on its own thread so chart redraws and exports cannot delay
+    // sensor reads. Set acquisition/dedicatedThread=false to compare jitter
+    // against polling from the GUI event loop.
+    if (settings.value("acquisition/dedicatedThread", true).toBool()) {
+        acquisitionThread = new QThread(this);
+        acquisitionThread->setObjectName("acquisition");
+        reader->moveToThread(acquisitionThread);
+        connect(acquisitionThread, &QThread::finished, reader, &QObject::deleteLater);
+        acquisitionThread->start(QThread::TimeCriticalPriority);
+    }
 
     reader->setSimulationMode(true);
+    // Simulated sweeps replay this recording instead of the built-in model
+    reader->setReplay(settings.value("replay/file").toString(),
+                      settings.value("replay/speed", 1.0).toDouble());
+    reader->setAdaptivePolling(settings.value("acquisition/adaptivePolling", true).toBool(),
+                               settings.value("acquisition/expectedLossFactor", 0.05).toFloat());
     reader->start(dlg->port(), dlg->baudRate(), dlg->dataBits(), dlg->parity(),
                   dlg->stopBits(), dlg->flowControl(), dlg->device1Address(), dlg->device2Address(), dlg->generatorAddress());
 
-    connect(reader, &ModbusReader::dataReady, this, [](int deviceId, int paramIndex, float value) {
-
-        if (paramIndex == FREQ || paramIndex == AMP)
-        qDebug() << "Device" << deviceId << "paramIndex:"<< paramIndex << "Value:" << value;
-
-    });
+    // Every reading crosses threads through this connection, so only make it
+    // when someone is listening
+    if (lcAcquisition().isDebugEnabled()) {
+        connect(reader, &ModbusReader::dataReady, this, [](int deviceId, int paramIndex, float value) {
+            if (paramIndex == FREQ || paramIndex == AMP)
+                qCDebugLimited(lcAcquisition, 500) << "Device" << deviceId << "paramIndex:" << paramIndex
+                                                   << "Value:" << value;
+        });
+    }
 
     connect(reader, &ModbusReader::errorOccurred, this, [](const QString &err) {
-        qWarning() << "Modbus error:" << err;
+        qCWarning(lcModbus) << "Modbus error:" << err;
     });
 
     QTimer* statusTimer = new QTimer(this);
@@ -90,16 +126,54 @@ MainWindow::MainWindow(QWidget *parent)
         sensor1Indicator->setState(l1);
         sensor2Indicator->setState(l2);
 
-        QString frmt = "Amp = %1 | Freq = %2 | Dist = %3";
-        QString s1 = QString("Sens 1: " + frmt).arg(amp1 / 1e3, 4, 'f' , 2).arg(freq1, 3, 'f', 1).arg(dist1 / 1e3, 3, 'f' , 1);
-        QString s2 = QString("Sens 2: " + frmt).arg(amp2 / 1e3, 4, 'f' , 2).arg(freq2, 3, 'f', 1).arg(dist2 / 1e3, 3, 'f' , 1);
+        QString frmt = "Amp = %1 | Freq = %2 | Dist = %3 | %4 Hz";
+        QString s1 = QString("Sens 1: " + frmt).arg(amp1 / 1e3, 4, 'f' , 2).arg(freq1, 3, 'f', 1).arg(dist1 / 1e3, 3, 'f' , 1)
+                         .arg(this->reader->sampleRate(0), 3, 'f', 1);
+        QString s2 = QString("Sens 2: " + frmt).arg(amp2 / 1e3, 4, 'f' , 2).arg(freq2, 3, 'f', 1).arg(dist2 / 1e3, 3, 'f' , 1)
+                         .arg(this->reader->sampleRate(1), 3, 'f', 1);
         status1->setText(s1);
         status2->setText(s2);
     });
 
+    exportProgress = new QProgressBar(this);
+    exportProgress->setRange(0, 100);
+    exportProgress->setFormat("Export %p%");
+    exportProgress->hide();
+    statusBar()->addWidget(exportProgress);
+
+    // Below the acquisition thread's priority, so a save never competes
+    // with polling
+    exportThread = new QThread(this);
+    exportThread->setObjectName("export");
+    exportWorker = new ExportWorker;
+    exportWorker->moveToThread(exportThread);
+    connect(exportThread, &QThread::finished, exportWorker, &QObject::deleteLater);
+    connect(exportWorker, &ExportWorker::progress, exportProgress, &QProgressBar::setValue);
+    connect(exportWorker, &ExportWorker::finished, this, &MainWindow::exportFinished);
+    exportThread->start(QThread::LowPriority);
+
     connect(qApp, &QCoreApplication::aboutToQuit, [=]() {
+        exportWorker->cancel();
+        exportThread->quit();
+        exportThread->wait();
+
         reader->stop();
-        reader->deleteLater();
+        if (acquisitionThread) {
+            acquisitionThread->quit();
+            acquisitionThread->wait();
+        } else {
+            reader->deleteLater();
+        }
+
+        // The recorder writes what is left and closes the file on deletion
+        recorderThread->quit();
+        recorderThread->wait();
+
+        // Field diagnostics: leave the session's metrics behind
+        const QString metricsFile = QSettings().value("diagnostics/dumpFile").toString();
+        QString error;
+        if (!metricsFile.isEmpty() && !Metrics::instance().dump(metricsFile, &error))
+            qWarning() << "Could not write metrics to" << metricsFile << ":" << error;
     });
 
     m_progressTimer = new QTimer(this);
@@ -115,7 +189,6 @@ MainWindow::MainWindow(QWidget *parent)
     ui->graph_box->layout()->addWidget(chart);
 
     // load last experiment parameters
-    QSettings settings;
     ui->start_freq->setText(settings.value("startFreq", 15).toString());
     ui->end_freq->setText(settings.value("endFreq", 35).toString());
     ui->duration->setText(settings.value("duration", 10).toString());
@@ -201,7 +274,16 @@ void MainWindow::start_generation()
         ModbusReader::SweepFminToFmax         // Direction
         );
 
-    reader->startRecording();
+    // The raw readings of every sweep are kept as a recording
+    QString recordingPath;
+    if (settings.value("recording/enabled", true).toBool()) {
+        QString defaultDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recordings";
+        QDir dir(settings.value("recording/dir", defaultDir).toString());
+        QString name = "Sweep_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".lfarec";
+        if (dir.mkpath("."))
+            recordingPath = dir.filePath(name);
+    }
+    reader->startRecording(recordingPath);
 }
 
 void MainWindow::on_actionAbout_triggered()
@@ -210,24 +292,54 @@ void MainWindow::on_actionAbout_triggered()
     dialog.exec();
 }
 
+void MainWindow::on_actionDiagnostics_triggered()
+{
+    // Modeless, so it can stay open next to a running sweep
+    if (!diagnostics)
+        diagnostics = new DiagnosticsDialog(this);
+    diagnostics->show();
+    diagnostics->raise();
+    diagnostics->activateWindow();
+}
+
 void MainWindow::on_actionAudio_Settings_triggered()
 {
 
 }
 
+void MainWindow::on_actionReplay_Recording_triggered()
+{
+    QSettings settings;
+    QString current = settings.value("replay/file").toString();
+    QString defaultDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recordings";
+
+    // Cancelling goes back to the built-in model
+    QString path = QFileDialog::getOpenFileName(
+        this,
+        "Replay Recording",
+        current.isEmpty() ? settings.value("recording/dir", defaultDir).toString() : current,
+        "Sweep recordings (*.lfarec)"
+        );
+
+    settings.setValue("replay/file", path);
+    reader->setReplay(path, settings.value("replay/speed", 1.0).toDouble());
+    if (!path.isEmpty())
+        statusBar()->showMessage("Start replays " + QFileInfo(path).fileName(), 5000);
+}
+
 void MainWindow::on_actionCOM_Port_Settings_triggered()
 {
     modbusconfigdialog dlg(this);
     if (dlg.exec() == QDialog::Accepted) {
-        qDebug() << "Port:" << dlg.port();
-        qDebug() << "Baud:" << dlg.baudRate();
-        qDebug() << "Data bits:" << dlg.dataBits();
-        qDebug() << "Parity:" << dlg.parity();
-        qDebug() << "Stop bits:" << dlg.stopBits();
-        qDebug() << "Device 1 Address:" << dlg.device1Address();
-        qDebug() << "Device 2 Address:" << dlg.device2Address();
-        qDebug() << "Generator Address:" << dlg.generatorAddress();
-        qDebug() << "Generator Volume:" << dlg.generatorVolume();
+        qCDebug(lcModbus) << "Port:" << dlg.port();
+        qCDebug(lcModbus) << "Baud:" << dlg.baudRate();
+        qCDebug(lcModbus) << "Data bits:" << dlg.dataBits();
+        qCDebug(lcModbus) << "Parity:" << dlg.parity();
+        qCDebug(lcModbus) << "Stop bits:" << dlg.stopBits();
+        qCDebug(lcModbus) << "Device 1 Address:" << dlg.device1Address();
+        qCDebug(lcModbus) << "Device 2 Address:" << dlg.device2Address();
+        qCDebug(lcModbus) << "Generator Address:" << dlg.generatorAddress();
+        qCDebug(lcModbus) << "Generator Volume:" << dlg.generatorVolume();
     }
 }
 
@@ -257,7 +369,7 @@ void MainWindow::updateProgressBar()
 
     if (progress == 100)
     {
-        qDebug() << "Done";
+        qCInfo(lcAcquisition) << "Done";
         is_generator_works = false;
         ui->start_btn->setText("Start");
         m_progressTimer->stop();
@@ -268,6 +380,13 @@ void MainWindow::updateProgressBar()
 
 void MainWindow::on_export_btn_clicked()
 {
+    // The button cancels a running export
+    if (exportWorker->busy()) {
+        exportWorker->cancel();
+        ui->export_btn->setEnabled(false);
+        return;
+    }
+
     if (!this->chart->is_success())
         return;
 
@@ -287,63 +406,58 @@ void MainWindow::on_export_btn_clicked()
         "Excel Files (*.xlsx)"
         );
 
-    if (!savePath.isEmpty())
-    {
-        // Save the directory for next time
-        QFileInfo fi(savePath);
-        settings.setValue("lastExportDir", fi.absolutePath());
-
-        // Load the template
-        Document xlsx(":/report_template.xlsx");
-        auto *wb = xlsx.workbook();
-        auto *sheet = wb->sheet(0);
-        if (!sheet) {
-            QMessageBox::warning(this, "Export Failed", "Sheet 'Results' not found in template.");
-            return;
-        }
-
-        // Fill named cells
-        xlsx.write("B6", chart->getPeakFreq());
-        xlsx.write("B7", chart->getpeakAmplitude());
-        xlsx.write("B8", chart->getthreshold());
-        xlsx.write("B9", chart->getf1());
-        xlsx.write("B10", chart->getf2());
-        xlsx.write("B11", chart->getdeltaF());
-        xlsx.write("B12", chart->getlossFactor());
-
-        QImage img = chart->getScreenShot();
-
-        xlsx.insertImage(14, 0, img);
-
-        xlsx.selectSheet("Raw data");
-
-        auto write_data = [&xlsx](std::vector<float> data, QString s) {
-
-             for (size_t i = 0; i < data.size(); i++)
-             {
-                 QString addr = s + QString::number(i + 2);
-                 xlsx.write(addr, data[i]);
-             }
-
-        };
+    if (savePath.isEmpty())
+        return;
 
-        write_data(chart->getXData(), "A");
-        write_data(chart->getYData1(), "B");
-        write_data(chart->getYData2(), "C");
-        write_data(chart->getYData(), "D");
+    // Save the directory for next time
+    QFileInfo fi(savePath);
+    settings.setValue("lastExportDir", fi.absolutePath());
+
+    // Only the widget work happens here; the worker builds and saves the workbook
+    ExportJob job;
+    job.path = savePath;
+    job.results = { chart->getPeakFreq(), chart->getpeakAmplitude(),
+                    chart->getthreshold(), chart->getf1(), chart->getf2(),
+                    chart->getdeltaF(), chart->getlossFactor() };
+    // Device pixels per screen pixel of the exported chart, 1 when unset or unusable
+    bool scaleOk = false;
+    qreal chartScale = settings.value("export/chartScale", 1.0).toReal(&scaleOk);
+    if (!scaleOk || !qIsFinite(chartScale))
+        chartScale = 1.0;
+    job.chart = chart->getScreenShot(qBound(0.5, chartScale, 4.0));
+    job.frames = chart->getFrames();
+
+    // Keep the export cheap while a test is running, archive small otherwise
+    job.policy = CompressionPolicy(is_generator_works ? CompressionPolicy::Fast
+                                                      : CompressionPolicy::Small);
+
+    if (!exportWorker->submit(job))
+        return;
 
-        xlsx.selectSheet("Report");
+    exportProgress->setValue(0);
+    exportProgress->show();
+    ui->export_btn->setText("Cancel");
+}
 
-        // Save to new file
-        if (!xlsx.saveAs(savePath)) {
-            QMessageBox::warning(this, "Export Failed", "Failed to save file.");
-            return;
-        }
+void MainWindow::exportFinished(const ExportResult &result)
+{
+    exportProgress->hide();
+    ui->export_btn->setText("Export");
+    ui->export_btn->setEnabled(true);
 
+    switch (result.status) {
+    case ExportResult::Saved:
+        qCInfo(lcExport) << "Export saved in" << result.durationMs << "ms";
         // Open the file with the default Excel application
-        QDesktopServices::openUrl(QUrl::fromLocalFile(savePath));
+        QDesktopServices::openUrl(QUrl::fromLocalFile(result.path));
+        break;
+    case ExportResult::Cancelled:
+        statusBar()->showMessage("Export cancelled", 3000);
+        break;
+    case ExportResult::Failed:
+        QMessageBox::warning(this, "Export Failed", result.error);
+        break;
     }
-
 }
 
 
@@ -7,6 +7,9 @@
 #include "modbusconfigdialog.h"
 #include "ledindicator.h"
 #include "modbusreader.h"
+#include "exportworker.h"
+
+class DiagnosticsDialog;
 
 
 QT_BEGIN_NAMESPACE
@@ -31,6 +34,8 @@ private slots:
     void on_actionAbout_triggered();
     void on_actionCOM_Port_Settings_triggered();
     void on_actionAudio_Settings_triggered();
+    void on_actionReplay_Recording_triggered();
+    void on_actionDiagnostics_triggered();
 
     void on_start_btn_clicked();
 
@@ -45,14 +50,25 @@ private:
     QTimer *m_progressTimer;
 
     ModbusReader *reader;
+    QThread *acquisitionThread = nullptr;
+    QThread *recorderThread = nullptr;
+    SweepRecorder *recorder = nullptr;
     LiveChartWidget* chart;
 
     bool is_generator_works = false;
     void stop_generation();
     void start_generation();
+
+    // Reports are built and saved on their own thread
+    QThread *exportThread = nullptr;
+    ExportWorker *exportWorker = nullptr;
+    QProgressBar *exportProgress;
+
+    DiagnosticsDialog *diagnostics = nullptr;
 private slots:
     void updateProgressBar();
     void on_export_btn_clicked();
+    void exportFinished(const ExportResult &result);
     void on_approximation_check_box_checkStateChanged(const Qt::CheckState &arg1);
 };
 #endif // MAINWINDOW_H
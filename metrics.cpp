@@ -0,0 +1,132 @@
+#include "metrics.h"
+#include <QDateTime>
+#include <QSaveFile>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+int Histogram::bucketOf(std::uint64_t ns) {
+    if (ns < SubBuckets) return int(ns);
+    const int exponent = 63 - int(qCountLeadingZeroBits(quint64(ns)));
+    if (exponent >= MaxExponent) return BucketCount - 1;
+    const int sub = int(ns >> (exponent - 3)) & (SubBuckets - 1);
+    return (exponent - 2) * SubBuckets + sub;
+}
+
+std::uint64_t Histogram::bucketLow(int bucket) {
+    if (bucket < SubBuckets) return std::uint64_t(bucket);
+    const int exponent = bucket / SubBuckets + 2;
+    return std::uint64_t(SubBuckets + bucket % SubBuckets) << (exponent - 3);
+}
+
+void Histogram::record(std::int64_t ns) {
+    const std::uint64_t v = ns > 0 ? std::uint64_t(ns) : 0;
+    m_buckets[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(v, std::memory_order_relaxed);
+    std::uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (v > max && !m_max.compare_exchange_weak(max, v, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot s;
+    for (int i = 0; i < BucketCount; ++i) {
+        s.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        s.count += s.buckets[i];
+    }
+    s.sumNs = m_sum.load(std::memory_order_relaxed);
+    s.maxNs = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+void Histogram::reset() {
+    for (auto &b : m_buckets) b.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+double HistogramSnapshot::percentileMs(double p) const {
+    if (count == 0) return 0.0;
+    const std::uint64_t rank =
+        std::max<std::uint64_t>(1, std::uint64_t(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * count)));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < Histogram::BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen < rank) continue;
+        const std::uint64_t low = Histogram::bucketLow(i);
+        const std::uint64_t high = i + 1 < Histogram::BucketCount ? Histogram::bucketLow(i + 1) : maxNs + 1;
+        return std::min<double>((low + high - 1) / 2.0, double(maxNs)) / 1e6;
+    }
+    return maxMs();
+}
+
+Metrics &Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Counter &Metrics::counter(const QString &name) {
+    QMutexLocker lock(&m_mutex);
+    auto &slot = m_counters[name];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Histogram &Metrics::histogram(const QString &name) {
+    QMutexLocker lock(&m_mutex);
+    auto &slot = m_histograms[name];
+    if (!slot) slot = std::make_unique<Histogram>();
+    return *slot;
+}
+
+QString Metrics::report() const {
+    QMutexLocker lock(&m_mutex);
+    QString out;
+
+    out += "Counters\n";
+    for (const auto &[name, counter] : m_counters)
+        out += QString("  %1 %2\n").arg(name, -36).arg(counter->value(), 12);
+
+    out += QString("\nHistograms (ms) %1 %2 %3 %4 %5 %6\n")
+               .arg(QString("count"), 33)
+               .arg(QString("mean"), 10)
+               .arg(QString("p50"), 10)
+               .arg(QString("p90"), 10)
+               .arg(QString("p99"), 10)
+               .arg(QString("max"), 10);
+    for (const auto &[name, histogram] : m_histograms) {
+        const HistogramSnapshot s = histogram->snapshot();
+        out += QString("  %1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(name, -36)
+                   .arg(s.count, 10)
+                   .arg(s.meanMs(), 10, 'f', 3)
+                   .arg(s.percentileMs(50), 10, 'f', 3)
+                   .arg(s.percentileMs(90), 10, 'f', 3)
+                   .arg(s.percentileMs(99), 10, 'f', 3)
+                   .arg(s.maxMs(), 10, 'f', 3);
+    }
+    return out;
+}
+
+bool Metrics::dump(const QString &path, QString *error) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    const QString text = QString("Metrics at %1\n\n")
+                             .arg(QDateTime::currentDateTime().toString(Qt::ISODateWithMs)) +
+                         report();
+    file.write(text.toUtf8());
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void Metrics::reset() {
+    QMutexLocker lock(&m_mutex);
+    for (auto &entry : m_counters) entry.second->reset();
+    for (auto &entry : m_histograms) entry.second->reset();
+}
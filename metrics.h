@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+// Event count. add() is a single relaxed atomic increment, safe from any thread.
+class Counter {
+public:
+    void add(std::uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> m_value{0};
+};
+
+struct HistogramSnapshot;
+
+// Lock-free distribution of durations in nanoseconds. Buckets are
+// log-linear, 8 per power of two, so a percentile is off by at most 12.5 %;
+// values from 2^40 ns (about 18 min) up share the last bucket. record() is
+// a handful of relaxed atomics and never blocks or allocates, so it can sit
+// on the acquisition and render paths. Readers get a snapshot that is
+// consistent per bucket, not across buckets, which is fine for monitoring.
+class Histogram {
+public:
+    static constexpr int SubBuckets = 8;
+    static constexpr int MaxExponent = 40;
+    static constexpr int BucketCount = (MaxExponent - 2) * SubBuckets;
+
+    void record(std::int64_t ns);
+    HistogramSnapshot snapshot() const;
+    void reset();
+
+    static int bucketOf(std::uint64_t ns);
+    static std::uint64_t bucketLow(int bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, BucketCount> m_buckets{};
+    std::atomic<std::uint64_t> m_sum{0};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+struct HistogramSnapshot {
+    std::array<std::uint64_t, Histogram::BucketCount> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t sumNs = 0;
+    std::uint64_t maxNs = 0;
+
+    double meanMs() const { return count ? sumNs / 1e6 / count : 0.0; }
+    double maxMs() const { return maxNs / 1e6; }
+    // Midpoint of the bucket holding the p-th percentile (0..100), capped at max
+    double percentileMs(double p) const;
+};
+
+// Times a scope into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram) : m_histogram(histogram) { m_timer.start(); }
+    ~ScopedTimer() { m_histogram.record(m_timer.nsecsElapsed()); }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Histogram &m_histogram;
+    QElapsedTimer m_timer;
+};
+
+// Process-wide registry of named counters and histograms. Metrics are
+// created on first lookup and live until exit, so the returned references
+// stay valid: look a metric up once (the lookup takes a mutex) and keep the
+// reference for the hot path. Names are dotted, "<area>.<what>".
+class Metrics {
+public:
+    static Metrics &instance();
+
+    Counter &counter(const QString &name);
+    Histogram &histogram(const QString &name);
+
+    // All metrics as a plain-text table sorted by name, times in ms
+    QString report() const;
+    // Writes report() with a timestamp header; false with error set on failure
+    bool dump(const QString &path, QString *error = nullptr) const;
+    void reset();
+
+private:
+    Metrics() = default;
+
+    mutable QMutex m_mutex;
+    std::map<QString, std::unique_ptr<Counter>> m_counters;
+    std::map<QString, std::unique_ptr<Histogram>> m_histograms;
+};
+
+#endif // METRICS_H
@@ -4,10 +4,19 @@
 #include <QModbusReply>
 #include <QSerialPort>
 #include <QDebug>
+#include <QDateTime>
+#include <algorithm>
+#include <cmath>
+#include "logging.h"
 
 ModbusReader::ModbusReader(QObject *parent) : QObject(parent) {
+    sampleClock.start();
     modbus = new QModbusRtuSerialClient(this);
+    // RTU is half duplex: one request on the wire at a time
+    scheduler = new ModbusScheduler(modbus, this);
+    scheduler->setMaxInFlight(1);
     pollTimer = new QTimer(this);
+    pollTimer->setTimerType(Qt::PreciseTimer);
     connect(pollTimer, &QTimer::timeout, this, &ModbusReader::readNextDevice);
 }
 
@@ -20,21 +29,35 @@ void ModbusReader::start(const QString &port, int baudRate, int dataBits,
                          const QString &flowControl,
                          int device1, int device2, int generatorId) {
 
-    qDebug() <<"Device addr 1:" <<device1;
-    qDebug() <<"Device addr 2:" <<device2;
-    qDebug() << "Generator Address:" << generatorId;
+    // Serial I/O and the poll timer belong to the reader's (acquisition) thread
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [=]() {
+            start(port, baudRate, dataBits, parity, stopBits, flowControl, device1, device2, generatorId);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    qCDebug(lcModbus) << "Device addr 1:" << device1 << "Device addr 2:" << device2
+                      << "Generator Address:" << generatorId;
 
     deviceIds = {device1, device2, generatorId};
 
     // Example: if simulation is enabled, skip Modbus init
     if (simulationMode) {
-        qDebug() << "Starting in simulation mode.";
+        qCInfo(lcModbus) << "Starting in simulation mode.";
 
         currentDeviceIndex = 0;
         active = true;
         recording = false;
         simTimer.start(); // Start fake clock
-        pollTimer->start(200);
+        resetPollTiming();
+        scheduler->resetRates();
+        basePollIntervalMs = 200;
+        busFloorMs = MinPollIntervalMs;
+        if (replay)
+            updateReplayTimer();
+        else
+            pollTimer->start(basePollIntervalMs);
         return;
     }
 
@@ -73,12 +96,34 @@ void ModbusReader::start(const QString &port, int baudRate, int dataBits,
     currentDeviceIndex = 0;
     active = true;
     recording = false;
-    pollTimer->start(300);
+    resetPollTiming();
+    scheduler->resetRates();
+    basePollIntervalMs = 300;
+    busFloorMs = MinPollIntervalMs;
+    pollTimer->start(basePollIntervalMs);
 }
 
 void ModbusReader::stop() {
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        // Block so the bus is released before the caller tears the thread down
+        QMetaObject::invokeMethod(this, [this]() { stop(); }, Qt::BlockingQueuedConnection);
+        return;
+    }
+
+    if (active) {
+        PollTimingStats t = pollTiming();
+        qCInfo(lcModbus) << "Poll timing: ticks" << t.ticks << "nominal" << t.nominalMs << "ms"
+                         << "mean" << t.meanIntervalMs << "ms"
+                         << "jitter rms" << t.jitterRmsMs << "ms max" << t.maxJitterMs << "ms"
+                         << "dropped samples" << samples.dropped()
+                         << "stale polls" << scheduler->droppedCount()
+                         << "rate [Hz] s1" << sampleRate(0) << "s2" << sampleRate(1)
+                         << "gen" << sampleRate(GeneratorKey);
+    }
+
     active = false;
     pollTimer->stop();
+    scheduler->clear();
     if (modbus && modbus->state() != QModbusDevice::UnconnectedState)
         modbus->disconnectDevice();
 }
@@ -87,24 +132,182 @@ bool ModbusReader::isWorking() const {
     return active && modbus && modbus->state() == QModbusDevice::ConnectedState;
 }
 
-void ModbusReader::startRecording() {
+void ModbusReader::startRecording(const QString &recordingPath) {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [=]() { startRecording(recordingPath); }, Qt::QueuedConnection);
+        return;
+    }
+    // A replay is not recorded again
+    const bool replaying = simulationMode && replay;
+    if (recorder && !recordingPath.isEmpty() && !replaying)
+        recorder->open(recordingPath, recordingHeader());
+    if (replaying) {
+        replayCursor = 0;
+        replayClock.restart();
+        m_generation_finished = false;
+    }
     recording = true;
+    if (replaying)
+        updateReplayTimer();
     simTimer.restart();
+    ratioPeak = 0;
+    ratioBaseline = 0;
 
 }
 
 void ModbusReader::stopRecording() {
     recording = false;
+    if (recorder)
+        recorder->close();
+}
+
+// Bus and sweep configuration in force, on the reader's thread
+RecordingHeader ModbusReader::recordingHeader() const {
+    RecordingHeader h = {};
+    h.simulated = simulationMode;
+    h.startedMsUtc = QDateTime::currentMSecsSinceEpoch();
+    for (int i = 0; i < 3; ++i)
+        h.deviceIds[i] = i < deviceIds.size() ? deviceIds[i] : -1;
+    h.pollIntervalMs = basePollIntervalMs;
+    h.adaptivePolling = adaptivePolling;
+    h.expectedLossFactor = expectedLossFactor;
+    h.amplitudePercent = m_sweep_amplitude;
+    h.startFreq = m_start_freq;
+    h.endFreq = m_end_freq;
+    h.sweepSpeedHzMin = m_sweep_speed;
+    h.cycles = m_sweep_cycles;
+    h.direction = m_sweep_direction;
+    return h;
+}
+
+void ModbusReader::setAdaptivePolling(bool enabled, float expectedLossFactor) {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [=]() { setAdaptivePolling(enabled, expectedLossFactor); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+    adaptivePolling = enabled;
+    this->expectedLossFactor = expectedLossFactor;
+    if (!enabled && pollTimer->isActive())
+        pollTimer->setInterval(basePollIntervalMs);
+}
+
+// Choose the next poll interval from the sweep speed and the distance to the
+// resonance peak. The half-power band is about expectedLossFactor * f wide and
+// the sweep crosses it in band / (Hz/s) seconds; near the peak we poll fast
+// enough to put PointsPerBand samples into it, elsewhere CoarseFactor times
+// slower. The bus floor grows whenever polls are still queued at the next
+// tick, so the adaptive rate never asks for more than the bus delivers.
+void ModbusReader::updatePollInterval() {
+    if (scheduler->pendingCount() > 0)
+        busFloorMs = std::min<double>(MaxPollIntervalMs, busFloorMs * 1.25);
+    else
+        busFloorMs = std::max<double>(MinPollIntervalMs, busFloorMs * 0.99);
+
+    float sweepHzPerSec = m_sweep_speed / 60.0f;
+    if (!adaptivePolling || !recording || sweepHzPerSec <= 0) {
+        if (pollTimer->interval() != basePollIntervalMs)
+            pollTimer->setInterval(basePollIntervalMs);
+        return;
+    }
+
+    float freq = lastValues[0][FREQ];
+    if (freq <= 0) freq = m_start_freq;
+    float bandwidth = std::max(expectedLossFactor * freq, 1e-3f);
+    double fineMs = 1000.0 * bandwidth / sweepHzPerSec / PointsPerBand;
+
+    // Transmissibility |sensor 1 / sensor 2| tracks the resonance as in the chart
+    bool nearPeak = true;
+    float amp2 = lastValues[1][AMP];
+    if (amp2 != 0) {
+        float ratio = std::abs(lastValues[0][AMP] / amp2);
+        if (ratioBaseline <= 0 || ratio < ratioBaseline) ratioBaseline = ratio;
+        ratioPeak = std::max(ratioPeak, ratio);
+        nearPeak = ratio >= 2.0f * ratioBaseline && ratio >= 0.5f * ratioPeak;
+    }
+
+    double ms = nearPeak ? fineMs : fineMs * CoarseFactor;
+    int interval = int(std::clamp<double>(ms, busFloorMs, MaxPollIntervalMs));
+    if (std::abs(interval - pollTimer->interval()) > 5)
+        pollTimer->setInterval(interval);
 }
 
 void ModbusReader::clearData() {
+    // Discard anything still queued from the previous recording
+    samples.drain([](const AcqSample &) {});
     for (int i = 0; i < 3; ++i) {
-        data1_param[i].clear();
-        data2_param[i].clear();
+        sensorRecords[0][i].clear();
+        sensorRecords[1][i].clear();
     }
+    freqRecords.clear();
+    m_frames.clear();
+    aligner.reset();
 }
 
 
+void ModbusReader::publish(int devIdx, int paramIndex, float value, qint64 t_ns) {
+    enqueueSample({devIdx, paramIndex, value, t_ns});
+    if (recorder)
+        recorder->append(t_ns, devIdx, paramIndex, value);
+}
+
+void ModbusReader::enqueueSample(const AcqSample &sample) {
+    m_readingsMetric.add();
+    if (!samples.push(sample))
+        m_queueFullMetric.add();
+}
+
+void ModbusReader::collectSamples() {
+    size_t n = samples.drain([this](const AcqSample &s) {
+        if (s.paramIndex == FREQ) freqRecords.push_back({s.t_ns, s.value});
+        else sensorRecords[s.devIdx][s.paramIndex].push_back({s.t_ns, s.value});
+    });
+    if (n)
+        aligner.align(sensorRecords[0][AMP], sensorRecords[1][AMP], freqRecords, m_frames);
+}
+
+const std::vector<SampleRecord> &ModbusReader::records(int devIdx, int paramIndex) const {
+    if (paramIndex == FREQ) return freqRecords;
+    return sensorRecords[devIdx == 0 ? 0 : 1][paramIndex];
+}
+
+void ModbusReader::notePollTick() {
+    if (!tickClock.isValid()) tickClock.start();
+    qint64 now = tickClock.nsecsElapsed();
+
+    QMutexLocker lock(&timingMutex);
+    timing.nominalMs = pollTimer->interval();
+    if (lastTickNs >= 0) {
+        m_pollIntervalMetric.record(now - lastTickNs);
+        double interval = (now - lastTickNs) / 1e6;
+        double dev = interval - timing.nominalMs;
+        ++timing.ticks;
+        intervalSum += interval;
+        jitterSumSq += dev * dev;
+        timing.meanIntervalMs = intervalSum / timing.ticks;
+        timing.jitterRmsMs = std::sqrt(jitterSumSq / timing.ticks);
+        timing.maxJitterMs = std::max(timing.maxJitterMs, std::abs(dev));
+    }
+    lastTickNs = now;
+}
+
+PollTimingStats ModbusReader::pollTiming() const {
+    QMutexLocker lock(&timingMutex);
+    return timing;
+}
+
+void ModbusReader::resetPollTiming() {
+    QMutexLocker lock(&timingMutex);
+    timing = PollTimingStats();
+    lastTickNs = -1;
+    jitterSumSq = 0;
+    intervalSum = 0;
+}
+
+double ModbusReader::sampleRate(int devIdx) const {
+    return scheduler->sampleRate(devIdx);
+}
+
 bool ModbusReader::device1ReadSuccess() const {
     return status1;
 }
@@ -116,6 +319,15 @@ bool ModbusReader::device2ReadSuccess() const {
 
 void ModbusReader::readNextDevice() {
 
+    notePollTick();
+
+    if (simulationMode && replay) {
+        replayTick();
+        return;
+    }
+
+    updatePollInterval();
+
     if (simulationMode) {
         generateFakeData();
         return;
@@ -123,6 +335,9 @@ void ModbusReader::readNextDevice() {
 
     if (!isWorking()) return;
 
+    // Queue one poll per device. The scheduler paces them on the bus and a
+    // poll still queued at the next tick is replaced instead of stacking up.
+
     // Step 1: Read Sensor 1
     readSensorData(deviceIds[0], 0);
 
@@ -202,101 +417,82 @@ void ModbusReader::readNextDevice() {
 
 void ModbusReader::readSensorData(int deviceId, int devIdx)
 {
-    // Read vibration + gap in one request (2 floats = 4 registers)
-    QModbusDataUnit req(QModbusDataUnit::InputRegisters,
-                        RegSensorFlags,
-                        8);
+    // Read flags + vibration + gap in one request
+    ModbusScheduler::Request req;
+    req.serverAddress = deviceId;
+    req.unit = QModbusDataUnit(QModbusDataUnit::InputRegisters, RegSensorFlags, 8);
+    req.priority = PriorityPoll;
+    req.deadlineMs = scheduler->now() + pollTimer->interval();
+    req.key = devIdx;
+
+    req.onResult = [=](const QModbusDataUnit &result) {
+        qint64 t_ns = sampleClock.nsecsElapsed();
+        quint32 flags = convertToUint32(result);
+        float vibration = convertToFloat(result, 2);               // first 2 registers
+        float gap = convertToFloat(result, 4);                  // next 2 registers
+
+        if (devIdx == 1)
+        {
+            m_ready_to_record = flags & 0x0008;
+            m_generation_finished = flags & 0x0010;
+            qCDebugLimited(lcAcquisition, 1000) << "flags:" << flags
+                                                << "m_ready_to_record:" << m_ready_to_record
+                                                << "m_generation_finished:" << m_generation_finished;
+        }
 
-    if (auto *reply = modbus->sendReadRequest(req, deviceId)) {
-        if (!reply->isFinished()) {
-            connect(reply, &QModbusReply::finished, this, [=]() {
-                if (reply->error() == QModbusDevice::NoError) {
-                    quint32 flags = convertToUint32(reply->result());
-                    float vibration = convertToFloat(reply->result(), 2);               // first 2 registers
-                    float gap = convertToFloat(reply->result(), 4);                  // next 2 registers
-
-                    if (devIdx == 1)
-                    {
-                        m_ready_to_record = flags & 0x0008;
-                        m_generation_finished = flags & 0x0010;
-                        qDebug() << "flags:" << flags;
-                        qDebug() << "m_ready_to_record:" << m_ready_to_record
-                                 << "m_generation_finished:" << m_generation_finished;
-                    }
+        lastValues[devIdx][AMP] = vibration;
+        lastValues[devIdx][DIST] = gap;
 
-                    lastValues[devIdx][AMP] = vibration;
-                    lastValues[devIdx][DIST] = gap;
-
-                    if (recording && m_ready_to_record) {
-                        if (devIdx == 0) {
-                            data1_param[AMP].push_back(vibration);
-                            data1_param[DIST].push_back(gap);
-                        } else {
-                            data2_param[AMP].push_back(vibration);
-                            data2_param[DIST].push_back(gap);
-                        }
-                    }
+        if (recording && m_ready_to_record) {
+            publish(devIdx, AMP, vibration, t_ns);
+            publish(devIdx, DIST, gap, t_ns);
+        }
 
-                    emit dataReady(deviceId, AMP, vibration);
-                    emit dataReady(deviceId, DIST, gap);
+        emit dataReady(deviceId, AMP, vibration);
+        emit dataReady(deviceId, DIST, gap);
 
-                    if (devIdx == 0) status1 = true;
-                    else status2 = true;
-                } else {
-                    emit errorOccurred(reply->errorString());
-                    if (devIdx == 0) status1 = false;
-                    else status2 = false;
-                }
-                reply->deleteLater();
-            });
-        } else {
-            reply->deleteLater();
-        }
-    } else {
-        emit errorOccurred("Failed to send Modbus request (Sensor).");
+        if (devIdx == 0) status1 = true;
+        else status2 = true;
+    };
+    req.onError = [=](const QString &error) {
+        emit errorOccurred("Sensor request failed: " + error);
         if (devIdx == 0) status1 = false;
         else status2 = false;
-    }
+    };
+
+    scheduler->enqueue(std::move(req));
 }
 
 void ModbusReader::readGeneratorData(int generatorId)
 {
     // Read cycles (uint32) + current frequency (float32) in one request = 4 registers
-    QModbusDataUnit req(QModbusDataUnit::InputRegisters,
-                        RegCycles,
-                        4);
-
-    if (auto *reply = modbus->sendReadRequest(req, generatorId)) {
-        if (!reply->isFinished()) {
-            connect(reply, &QModbusReply::finished, this, [=]() {
-                if (reply->error() == QModbusDevice::NoError) {
-                    quint32 cycles = convertToUint32(reply->result());        // first 2 registers
-                    float curFreq   = convertToFloat(reply->result(), 2);     // next 2 registers
-
-                    // Here you can store or emit these values as needed
-                    qDebug() << "Generator cycles:" << cycles
-                             << "Current freq:" << curFreq;
-
-                    lastValues[0][FREQ] = curFreq;
-                    lastValues[1][FREQ] = curFreq;
-
-                    if (recording && m_ready_to_record) {
-                            data1_param[FREQ].push_back(curFreq);
-                            data2_param[FREQ].push_back(curFreq);
-                    }
-
-
-                } else {
-                    emit errorOccurred(reply->errorString());
-                }
-                reply->deleteLater();
-            });
-        } else {
-            reply->deleteLater();
+    ModbusScheduler::Request req;
+    req.serverAddress = generatorId;
+    req.unit = QModbusDataUnit(QModbusDataUnit::InputRegisters, RegCycles, 4);
+    req.priority = PriorityPoll;
+    req.deadlineMs = scheduler->now() + pollTimer->interval();
+    req.key = GeneratorKey;
+
+    req.onResult = [this](const QModbusDataUnit &result) {
+        qint64 t_ns = sampleClock.nsecsElapsed();
+        quint32 cycles = convertToUint32(result);        // first 2 registers
+        float curFreq   = convertToFloat(result, 2);     // next 2 registers
+
+        qCDebugLimited(lcAcquisition, 1000) << "Generator cycles:" << cycles
+                                            << "Current freq:" << curFreq;
+
+        lastValues[0][FREQ] = curFreq;
+        lastValues[1][FREQ] = curFreq;
+
+        if (recording && m_ready_to_record) {
+            publish(GeneratorKey, FREQ, curFreq, t_ns);
         }
-    } else {
-        emit errorOccurred("Failed to send Modbus request (Generator).");
-    }
+    };
+    req.onError = [this](const QString &error) {
+        emit errorOccurred("Generator request failed: " + error);
+    };
+
+    scheduler->enqueue(std::move(req));
 }
 
 
@@ -307,6 +503,7 @@ void ModbusReader::setSimulationMode(bool enabled) {
 
 
 void ModbusReader::generateFakeData() {
+    qint64 t_ns = sampleClock.nsecsElapsed(); // all simulated readings share one instant
     qint64 ms = simTimer.elapsed();
     float t = ms / 1000.0f; // seconds
 
@@ -328,19 +525,106 @@ void ModbusReader::generateFakeData() {
             emit dataReady(deviceIds[devIdx], i, value);
 
 
-            if (recording) {
-                if (devIdx == 0) data1_param[i].push_back(value);
-                else if (devIdx == 1) data2_param[i].push_back(value);
-            }
+            // the generator frequency is one reading, not one per sensor
+            if (recording && !(i == FREQ && devIdx == 1))
+                publish(i == FREQ ? GeneratorKey : devIdx, i, value, t_ns);
 
             if (devIdx == 0) status1 = true;
             else if (devIdx == 1) status2 = true;
         }
+        scheduler->markSample(devIdx);
     }
+    scheduler->markSample(GeneratorKey);
 
     currentDeviceIndex = (currentDeviceIndex + 1) % deviceIds.size();
 }
 
+void ModbusReader::setReplay(const QString &path, double speed) {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [=]() { setReplay(path, speed); }, Qt::QueuedConnection);
+        return;
+    }
+
+    replay.reset();
+    replaySpeed = speed;
+    if (!path.isEmpty()) {
+        auto view = std::make_unique<RecordingView>(path);
+        if (!view->isOpen())
+            emit errorOccurred("Cannot replay " + path + ": " + view->errorString());
+        else if (view->empty())
+            emit errorOccurred("Cannot replay " + path + ": no readings");
+        else
+            replay = std::move(view);
+    }
+    replayCursor = 0;
+    replayClock.start();
+
+    if (active && simulationMode) {
+        if (replay)
+            updateReplayTimer();
+        else
+            pollTimer->start(basePollIntervalMs);
+    }
+}
+
+// The poll timer drives a replay only while it plays: stopped before the
+// recording starts, after it stops and once the last reading is out
+void ModbusReader::updateReplayTimer() {
+    const bool playing = active && recording && replayCursor < replay->size();
+    if (!playing)
+        pollTimer->stop();
+    else if (!pollTimer->isActive())
+        pollTimer->start(ReplayTickMs);
+}
+
+// Hands on the recorded readings the replay clock has reached (at unlimited
+// speed, as many as the hand-off queue takes) and flags the end of the sweep
+// after the last.
+void ModbusReader::replayTick() {
+    if (!recording) {
+        updateReplayTimer();
+        return;
+    }
+
+    // Never more than the hand-off queue takes: a replay loses no readings
+    const std::size_t room = samples.capacity() - samples.size();
+    const std::size_t batch = replaySpeed > 0 ? std::min(room, ReplayBatch) : room;
+    const std::size_t limit = std::min(replay->size(), replayCursor + batch);
+    std::size_t end = limit;
+    if (replaySpeed > 0) {
+        const qint64 until = (*replay)[0].t_ns + qint64(replayClock.nsecsElapsed() * replaySpeed);
+        end = replayCursor;
+        while (end < limit && (*replay)[end].t_ns <= until) ++end;
+    }
+
+    for (; replayCursor < end; ++replayCursor) {
+        const RecordedSample &s = (*replay)[replayCursor];
+        deliver(s.devIdx, s.paramIndex, s.value, s.t_ns);
+    }
+    if (replayCursor == replay->size()) {
+        m_generation_finished = true;
+        updateReplayTimer();
+    }
+}
+
+// One replayed reading, as the poll callbacks handle a live one
+void ModbusReader::deliver(int devIdx, int paramIndex, float value, qint64 t_ns) {
+    if (devIdx == GeneratorKey) {
+        lastValues[0][FREQ] = value;
+        lastValues[1][FREQ] = value;
+    } else {
+        lastValues[devIdx][paramIndex] = value;
+        if (devIdx == 0) status1 = true;
+        else status2 = true;
+    }
+    emit dataReady(deviceIds.value(devIdx), paramIndex, value);
+
+    enqueueSample({devIdx, paramIndex, value, t_ns});
+    // One mark per poll, as live: a sensor poll yields AMP and DIST
+    if (devIdx == GeneratorKey || paramIndex == AMP)
+        scheduler->markSample(devIdx);
+}
+
 float ModbusReader::convertToFloat(const QModbusDataUnit &unit) const {
     if (unit.valueCount() < 2) return -1.0f;
 
@@ -360,9 +644,19 @@ void ModbusReader::startSweep(float amplitudePercent,
                               quint32 cycles,
                               SweepDirection direction)
 {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [=]() {
+            startSweep(amplitudePercent, startFreq, endFreq, sweepSpeedHzMin, cycles, direction);
+        }, Qt::QueuedConnection);
+        return;
+    }
 
     m_start_freq = startFreq;
     m_end_freq = endFreq;
+    m_sweep_speed = sweepSpeedHzMin;
+    m_sweep_amplitude = amplitudePercent;
+    m_sweep_cycles = cycles;
+    m_sweep_direction = direction;
 
     int generatorId = 0;
     if (deviceIds.size() == 3)
@@ -395,6 +689,11 @@ void ModbusReader::startSweep(float amplitudePercent,
 
 void ModbusReader::stopSweep()
 {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this]() { stopSweep(); }, Qt::QueuedConnection);
+        return;
+    }
+
     int generatorId = 0;
     if (deviceIds.size() == 3)
         generatorId = deviceIds[2]; // get Generator ID
@@ -407,21 +706,20 @@ void ModbusReader::stopSweep()
 
 
 void ModbusReader::writeHoldingRegisters(int deviceId, quint16 startAddress, const QVector<quint16> &values) {
-    QModbusDataUnit writeUnit(QModbusDataUnit::HoldingRegisters, startAddress, values.size());
-
+    ModbusScheduler::Request req;
+    req.kind = ModbusScheduler::Write;
+    req.serverAddress = deviceId;
+    req.unit = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, startAddress, values.size());
     for (int i = 0; i < values.size(); ++i)
-        writeUnit.setValue(i, values[i]);
+        req.unit.setValue(i, values[i]);
 
-    if (auto *reply = modbus->sendWriteRequest(writeUnit, deviceId)) {
-        connect(reply, &QModbusReply::finished, this, [reply]() {
-            if (reply->error() != QModbusDevice::NoError) {
-                qWarning() << "Write error:" << reply->errorString();
-            }
-            reply->deleteLater();
-        });
-    } else {
-        qWarning() << "Failed to send Modbus write request.";
-    }
+    // Generator configuration must never be dropped and goes ahead of polls
+    req.priority = PriorityWrite;
+    req.onError = [](const QString &error) {
+        qCWarning(lcModbus) << "Write error:" << error;
+    };
+
+    scheduler->enqueue(std::move(req));
 }
 
 
@@ -483,9 +781,10 @@ int ModbusReader::getProgress()
     //    return 0;
 
     float x = this->lastValues[0][FREQ];
-    if ( x < m_start_freq || x > m_end_freq )
+    float f_start = m_start_freq, f_end = m_end_freq;
+    if ( x < f_start || x > f_end )
         return 0;
 
-    int res = 100.0 / (m_end_freq - m_start_freq) * (x - m_start_freq);
+    int res = 100.0 / (f_end - f_start) * (x - f_start);
     return res;
 }
@@ -7,9 +7,34 @@
 #include <QModbusRtuSerialClient>
 #include <QTimer>
 #include <QThread>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <atomic>
+#include <memory>
 #include <vector>
-
-enum params_list { AMP, FREQ, DIST };
+#include "spscringbuffer.h"
+#include "modbusscheduler.h"
+#include "samplerecord.h"
+#include "sweeprecorder.h"
+#include "recordingview.h"
+#include "metrics.h"
+
+// One decoded reading handed from the acquisition thread to the GUI thread.
+struct AcqSample {
+    int devIdx;        // 0 = sensor 1, 1 = sensor 2, 2 = generator
+    int paramIndex;    // params_list
+    float value;
+    qint64 t_ns;       // acquisition clock at decode time
+};
+
+// Poll tick timing, measured on the thread that runs readNextDevice().
+struct PollTimingStats {
+    quint64 ticks = 0;
+    double nominalMs = 0;      // configured poll interval
+    double meanIntervalMs = 0; // mean measured interval between ticks
+    double jitterRmsMs = 0;    // RMS deviation from the nominal interval
+    double maxJitterMs = 0;    // worst absolute deviation
+};
 
 class ModbusReader : public QObject {
     Q_OBJECT
@@ -70,21 +95,52 @@ public:
     void stop();
     bool isWorking() const;
 
-    void startRecording();
+    // With a recording path and a recorder set, the readings of the sweep
+    // are also streamed to that file, see SweepRecorder.
+    void startRecording(const QString &recordingPath = QString());
     void stopRecording();
+    // Set before start(); not owned
+    void setRecorder(SweepRecorder *recorder) { this->recorder = recorder; }
     void clearData();
 
+    // Derive the poll interval from the sweep speed and resonance proximity
+    // instead of the fixed 300/200 ms. expectedLossFactor sets the expected
+    // half-power bandwidth (eta * f).
+    void setAdaptivePolling(bool enabled, float expectedLossFactor = 0.05f);
+
+    // GUI thread: move samples published by the acquisition thread into the
+    // recorded series and extend frames(). Call before reading recorded data.
+    void collectSamples();
+
+    PollTimingStats pollTiming() const;
+    void resetPollTiming();
+
     // Accessors for last values
     float lastValue(int deviceIndex, int paramIndex) const;
 
+    // Achieved reply rate in Hz; devIdx 0/1 = sensors, GeneratorKey = generator
+    double sampleRate(int devIdx) const;
+    static constexpr int GeneratorKey = 2;
+
     bool device1ReadSuccess() const;
     bool device2ReadSuccess() const;
 
-    std::vector<float> device1Data(int paramIndex) const { return data1_param[paramIndex]; }
-    std::vector<float> device2Data(int paramIndex) const { return data2_param[paramIndex]; }
+    // Recorded data lives on the GUI thread, see collectSamples().
+    // Time-aligned sensor/generator frames, one per sensor 1 amplitude reading.
+    // The snapshot shares storage with the reader (no copy) and stays valid
+    // and unchanged while recording continues or after clearData().
+    FrameSnapshot frames() const { return m_frames.snapshot(); }
+    // Raw timestamped readings; devIdx 0/1 = sensors, GeneratorKey for FREQ.
+    const std::vector<SampleRecord> &records(int devIdx, int paramIndex) const;
 
     void setSimulationMode(bool enabled);
     void generateFakeData();
+    // Simulation mode: replay the readings of a recording instead of the
+    // generateFakeData() model, at speed times real time (<= 0: as fast as
+    // possible). Readings take the live path (dataReady, recorded series)
+    // with their recorded timestamps, from startRecording() on. An empty
+    // path goes back to the model.
+    void setReplay(const QString &path, double speed = 1.0);
 
     int getProgress();
 
@@ -97,22 +153,60 @@ private slots:
 
 private:
     QModbusClient *modbus = nullptr;
+    ModbusScheduler *scheduler = nullptr;
     QTimer *pollTimer = nullptr;
-    bool active = false;
-    bool recording = false;
 
-    int currentDeviceIndex = 0;
-    QVector<int> deviceIds;
+    enum RequestPriority { PriorityWrite = 0, PriorityPoll = 1 };
 
-    std::vector<float> data1_param[3]; // 3 parameters for device 1
-    std::vector<float> data2_param[3]; // 3 parameters for device 2
+    // Adaptive polling (acquisition thread)
+    static constexpr int MinPollIntervalMs = 50;
+    static constexpr int MaxPollIntervalMs = 1000;
+    static constexpr int PointsPerBand = 20;
+    static constexpr int CoarseFactor = 4;
+    bool adaptivePolling = false;
+    float expectedLossFactor = 0.05f;
+    int basePollIntervalMs = 300;
+    double busFloorMs = MinPollIntervalMs;
+    float ratioPeak = 0, ratioBaseline = 0;
+    void updatePollInterval();
 
+    std::atomic<bool> active{false};
+    std::atomic<bool> recording{false};
 
-    bool status1 = false;
-    bool status2 = false;
+    int currentDeviceIndex = 0;
+    QVector<int> deviceIds;
 
-    bool m_ready_to_record = false;
-    bool m_generation_finished = false;
+    // Recorded readings (GUI thread)
+    std::vector<SampleRecord> sensorRecords[2][3]; // AMP and DIST per sensor
+    std::vector<SampleRecord> freqRecords;         // generator frequency
+    FrameStore m_frames;
+    FrameAligner aligner;
+
+    // Acquisition thread -> GUI thread hand-off of recorded samples
+    SpscRingBuffer<AcqSample, 8192> samples;
+    QElapsedTimer sampleClock;
+    void publish(int devIdx, int paramIndex, float value, qint64 t_ns);
+    void enqueueSample(const AcqSample &sample);
+    Counter &m_readingsMetric = Metrics::instance().counter("acq.readings");
+    Counter &m_queueFullMetric = Metrics::instance().counter("acq.queue_full");
+    SweepRecorder *recorder = nullptr;
+    RecordingHeader recordingHeader() const;
+
+    std::atomic<bool> status1{false};
+    std::atomic<bool> status2{false};
+
+    std::atomic<bool> m_ready_to_record{false};
+    std::atomic<bool> m_generation_finished{false};
+
+    // Poll jitter measurement
+    QElapsedTimer tickClock;
+    qint64 lastTickNs = -1;
+    double jitterSumSq = 0;
+    double intervalSum = 0;
+    mutable QMutex timingMutex;
+    PollTimingStats timing;
+    Histogram &m_pollIntervalMetric = Metrics::instance().histogram("acq.poll_interval");
+    void notePollTick();
 
     void readGeneratorData(int generatorId);
     void readSensorData(int deviceId, int devIdx);
@@ -127,13 +221,28 @@ private:
 
     void writeHoldingRegisters(int deviceId, quint16 startAddress, const QVector<quint16> &values);
     // Latest values for each parameter for each device
-    float lastValues[2][3] = {{0.0f}}; // 2 devices x 3 parameters
+    std::atomic<float> lastValues[2][3] = {}; // 2 devices x 3 parameters
 
     bool simulationMode;
 
     QElapsedTimer simTimer;
 
-    float m_start_freq, m_end_freq;
+    // Replay (acquisition thread)
+    static constexpr int ReplayTickMs = 20;          // also at unlimited speed
+    static constexpr std::size_t ReplayBatch = 4096; // most readings per timed tick
+    std::unique_ptr<RecordingView> replay;
+    double replaySpeed = 1.0;
+    std::size_t replayCursor = 0;
+    QElapsedTimer replayClock;
+    void updateReplayTimer();
+    void replayTick();
+    void deliver(int devIdx, int paramIndex, float value, qint64 t_ns);
+
+    std::atomic<float> m_start_freq{0}, m_end_freq{0};
+    float m_sweep_speed = 0; // Hz/min
+    float m_sweep_amplitude = 0;
+    quint32 m_sweep_cycles = 0;
+    quint32 m_sweep_direction = SweepFminToFmax;
 
 
  };
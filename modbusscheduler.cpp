@@ -0,0 +1,148 @@
+#include "modbusscheduler.h"
+#include <QModbusReply>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include "metrics.h"
+
+ModbusScheduler::ModbusScheduler(QModbusClient *client, QObject *parent)
+    : QObject(parent), m_client(client)
+    , m_droppedMetric(Metrics::instance().counter("modbus.dropped_polls"))
+{
+    m_clock.start();
+}
+
+void ModbusScheduler::setMaxInFlight(int n)
+{
+    m_maxInFlight = std::max(1, n);
+    dispatch();
+}
+
+void ModbusScheduler::enqueue(Request req)
+{
+    if (req.key >= 0) {
+        auto it = std::find_if(m_queue.begin(), m_queue.end(), [&](const Entry &e) {
+            return e.req.key == req.key;
+        });
+        if (it != m_queue.end()) {
+            // The queued poll never made it onto the bus; the new one supersedes it
+            it->req = std::move(req);
+            it->seq = m_seq++;
+            ++m_dropped;
+            m_droppedMetric.add();
+            dispatch();
+            return;
+        }
+    }
+
+    m_queue.push_back({std::move(req), m_seq++});
+    dispatch();
+}
+
+void ModbusScheduler::clear()
+{
+    m_queue.clear();
+}
+
+void ModbusScheduler::dispatch()
+{
+    while (m_inFlight < m_maxInFlight && !m_queue.empty()) {
+        // Small queue (a few entries per device): a linear scan beats a heap here
+        auto best = std::min_element(m_queue.begin(), m_queue.end(), [](const Entry &a, const Entry &b) {
+            if (a.req.priority != b.req.priority) return a.req.priority < b.req.priority;
+            qint64 da = a.req.deadlineMs < 0 ? std::numeric_limits<qint64>::max() : a.req.deadlineMs;
+            qint64 db = b.req.deadlineMs < 0 ? std::numeric_limits<qint64>::max() : b.req.deadlineMs;
+            if (da != db) return da < db;
+            return a.seq < b.seq;
+        });
+        Request req = std::move(best->req);
+        m_queue.erase(best);
+
+        if (req.deadlineMs >= 0 && now() > req.deadlineMs) {
+            ++m_dropped;
+            m_droppedMetric.add();
+            continue;
+        }
+
+        const qint64 sentNs = m_clock.nsecsElapsed();
+        QModbusReply *reply = req.kind == Write
+                                  ? m_client->sendWriteRequest(req.unit, req.serverAddress)
+                                  : m_client->sendReadRequest(req.unit, req.serverAddress);
+        if (!reply) {
+            deviceMetrics(req.serverAddress).errors->add();
+            if (req.onError) req.onError(m_client->errorString());
+            continue;
+        }
+
+        if (reply->isFinished()) {
+            // broadcast replies return immediately
+            complete(req, reply, sentNs);
+            continue;
+        }
+
+        ++m_inFlight;
+        connect(reply, &QModbusReply::finished, this, [this, req, reply, sentNs]() {
+            --m_inFlight;
+            complete(req, reply, sentNs);
+            dispatch();
+        });
+    }
+}
+
+void ModbusScheduler::complete(const Request &req, QModbusReply *reply, qint64 sentNs)
+{
+    DeviceMetrics &metrics = deviceMetrics(req.serverAddress);
+    metrics.rtt->record(m_clock.nsecsElapsed() - sentNs);
+
+    if (reply->error() == QModbusDevice::NoError) {
+        metrics.replies->add();
+        if (req.key >= 0) markSample(req.key);
+        if (req.onResult) req.onResult(reply->result());
+    } else {
+        metrics.errors->add();
+        if (req.onError) req.onError(reply->errorString());
+    }
+    reply->deleteLater();
+}
+
+ModbusScheduler::DeviceMetrics &ModbusScheduler::deviceMetrics(int serverAddress)
+{
+    auto it = m_deviceMetrics.find(serverAddress);
+    if (it == m_deviceMetrics.end()) {
+        const QString prefix = QString("modbus.dev%1.").arg(serverAddress);
+        Metrics &registry = Metrics::instance();
+        it = m_deviceMetrics.insert(serverAddress, {&registry.histogram(prefix + "rtt"),
+                                                     &registry.counter(prefix + "replies"),
+                                                     &registry.counter(prefix + "errors")});
+    }
+    return *it;
+}
+
+void ModbusScheduler::markSample(int key)
+{
+    qint64 t = now();
+    QMutexLocker lock(&m_rateMutex);
+    auto &times = m_completions[key];
+    times.push_back(t);
+    while (!times.empty() && t - times.front() > RateWindowMs)
+        times.pop_front();
+}
+
+double ModbusScheduler::sampleRate(int key) const
+{
+    qint64 t = now();
+    QMutexLocker lock(&m_rateMutex);
+    auto it = m_completions.constFind(key);
+    if (it == m_completions.constEnd()) return 0.0;
+
+    int n = 0;
+    for (qint64 c : *it)
+        if (t - c <= RateWindowMs) ++n;
+    return n * 1000.0 / RateWindowMs;
+}
+
+void ModbusScheduler::resetRates()
+{
+    QMutexLocker lock(&m_rateMutex);
+    m_completions.clear();
+}
@@ -0,0 +1,96 @@
+#ifndef MODBUSSCHEDULER_H
+#define MODBUSSCHEDULER_H
+
+#pragma once
+
+#include <QObject>
+#include <QModbusClient>
+#include <QModbusDataUnit>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <deque>
+#include <functional>
+#include <vector>
+
+class Counter;
+class Histogram;
+
+// Per-bus request queue for a QModbusClient.
+// Keeps at most maxInFlight() requests on the wire, serves queued requests by
+// priority and then deadline, replaces a queued poll when a newer one with the
+// same key arrives and drops polls whose deadline has passed instead of
+// letting them pile up behind a slow device.
+// Round-trip times and replies per device go to the metrics registry as
+// "modbus.dev<address>.*".
+class ModbusScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    enum Kind { Read, Write };
+
+    struct Request {
+        Kind kind = Read;
+        int serverAddress = 0;
+        QModbusDataUnit unit;
+        int priority = 0;         // lower value is served first
+        qint64 deadlineMs = -1;   // on now() clock, -1 = never stale
+        int key = -1;             // >= 0: newer request with same key replaces a queued one
+        std::function<void(const QModbusDataUnit &)> onResult;
+        std::function<void(const QString &)> onError;
+    };
+
+    explicit ModbusScheduler(QModbusClient *client, QObject *parent = nullptr);
+
+    void setMaxInFlight(int n);
+    int maxInFlight() const { return m_maxInFlight; }
+
+    // Scheduler clock in ms, used for deadlines
+    qint64 now() const { return m_clock.elapsed(); }
+
+    void enqueue(Request req);
+    void clear();
+
+    int pendingCount() const { return int(m_queue.size()); }
+    int inFlightCount() const { return m_inFlight; }
+    quint64 droppedCount() const { return m_dropped; }
+
+    // Successful completions per second for key over the last rate window.
+    // Safe to call from any thread.
+    double sampleRate(int key) const;
+    // Count a completion for key that did not go through the bus (simulation)
+    void markSample(int key);
+    void resetRates();
+
+private:
+    struct Entry {
+        Request req;
+        quint64 seq;
+    };
+
+    QModbusClient *m_client;
+    std::vector<Entry> m_queue;
+    int m_maxInFlight = 1;
+    int m_inFlight = 0;
+    quint64 m_seq = 0;
+    quint64 m_dropped = 0;
+    QElapsedTimer m_clock;
+
+    static constexpr qint64 RateWindowMs = 2000;
+    mutable QMutex m_rateMutex;
+    QHash<int, std::deque<qint64>> m_completions;
+
+    struct DeviceMetrics {
+        Histogram *rtt;
+        Counter *replies;
+        Counter *errors;
+    };
+    QHash<int, DeviceMetrics> m_deviceMetrics;
+    Counter &m_droppedMetric;
+
+    void dispatch();
+    void complete(const Request &req, QModbusReply *reply, qint64 sentNs);
+    DeviceMetrics &deviceMetrics(int serverAddress);
+};
+
+#endif // MODBUSSCHEDULER_H
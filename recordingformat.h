@@ -0,0 +1,73 @@
+#ifndef RECORDINGFORMAT_H
+#define RECORDINGFORMAT_H
+
+#pragma once
+
+#include <QtGlobal>
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of a sweep recording (*.lfarec), native little-endian:
+//
+//   RecordingHeader   sizeof(RecordingHeader) bytes
+//   RecordedSample    one per reading, in acquisition order, until EOF
+//
+// The sample count is not stored; it follows from the file size, so the
+// header is written once and the file is only ever appended to. A sample
+// torn by a crash, or zero padding the file system left after the last
+// complete one, fails the marker/sequence check and ends the recording.
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "recordings are little-endian");
+
+struct RecordingHeader {
+    static constexpr char Magic[8] = {'L', 'F', 'A', 'R', 'E', 'C', '\r', '\n'};
+    static constexpr std::uint32_t CurrentVersion = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;       // sizeof(RecordingHeader)
+    std::uint32_t sampleSize;       // sizeof(RecordedSample)
+    std::uint32_t simulated;        // 1 if recorded from the simulated bus
+    std::int64_t startedMsUtc;      // wall clock when recording started
+
+    // Poll configuration
+    std::int32_t deviceIds[3];      // Modbus addresses: sensor 1, sensor 2, generator
+    std::int32_t pollIntervalMs;    // base interval
+    std::int32_t adaptivePolling;
+    float expectedLossFactor;
+
+    // Sweep parameters
+    float amplitudePercent;
+    float startFreq;                // Hz
+    float endFreq;                  // Hz
+    float sweepSpeedHzMin;
+    std::uint32_t cycles;
+    std::uint32_t direction;        // ModbusReader::SweepDirection
+
+    char reserved[48];              // zero
+};
+
+static_assert(sizeof(RecordingHeader) == 128, "RecordingHeader layout changed");
+// No padding: every byte written to disk is a field
+static_assert(offsetof(RecordingHeader, reserved) + sizeof(RecordingHeader::reserved) == sizeof(RecordingHeader),
+              "RecordingHeader has tail padding");
+
+// One reading, as handed from the acquisition thread to the GUI.
+struct RecordedSample {
+    static constexpr std::uint8_t Marker = 0xA5;
+
+    std::int64_t t_ns;              // acquisition clock, as in SampleRecord
+    float value;
+    std::uint8_t devIdx;            // 0/1 = sensors, 2 = generator
+    std::uint8_t paramIndex;        // params_list
+    std::uint8_t marker;            // Marker
+    std::uint8_t sequence;          // sample index & 0xFF
+
+    bool valid(std::size_t index) const {
+        return marker == Marker && sequence == std::uint8_t(index) && devIdx <= 2 && paramIndex <= 2;
+    }
+};
+
+static_assert(sizeof(RecordedSample) == 16, "RecordedSample layout changed");
+
+#endif // RECORDINGFORMAT_H
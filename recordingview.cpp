@@ -0,0 +1,72 @@
+#include "recordingview.h"
+#include <cstring>
+#include <vector>
+
+bool RecordingView::open(const QString &path) {
+    close();
+    m_error.clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(m_file.errorString());
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(RecordingHeader)))
+        return fail("Not a recording: file too short");
+
+    m_map = m_file.map(0, fileSize);
+    if (!m_map)
+        return fail(m_file.errorString());
+
+    auto *header = reinterpret_cast<const RecordingHeader *>(m_map);
+    if (std::memcmp(header->magic, RecordingHeader::Magic, sizeof(header->magic)) != 0)
+        return fail("Not a recording: bad magic");
+    if (header->version != RecordingHeader::CurrentVersion)
+        return fail(QString("Unsupported recording version %1").arg(header->version));
+    if (header->headerSize < sizeof(RecordingHeader) || header->headerSize > fileSize ||
+        header->headerSize % sizeof(RecordedSample) != 0 || header->sampleSize != sizeof(RecordedSample))
+        return fail("Corrupt recording header");
+
+    // The mapping is page-aligned and the header size a multiple of the
+    // sample size, so the samples are properly aligned
+    auto *samples = reinterpret_cast<const RecordedSample *>(m_map + header->headerSize);
+    std::size_t n = std::size_t(fileSize - header->headerSize) / sizeof(RecordedSample);
+
+    // Only the tail can be damaged: drop samples until the last one checks out
+    while (n > 0 && !samples[n - 1].valid(n - 1))
+        --n;
+
+    m_header = header;
+    m_samples = samples;
+    m_size = n;
+    m_truncated = fileSize - header->headerSize - qint64(n * sizeof(RecordedSample));
+    return true;
+}
+
+void RecordingView::close() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_header = nullptr;
+    m_samples = nullptr;
+    m_size = 0;
+    m_truncated = 0;
+}
+
+bool RecordingView::fail(const QString &error) {
+    close();
+    m_error = error;
+    return false;
+}
+
+void RecordingView::alignFrames(FrameStore &out) const {
+    std::vector<SampleRecord> amp1, amp2, freq;
+    for (const RecordedSample &s : *this) {
+        if (s.paramIndex == FREQ) freq.push_back({s.t_ns, s.value});
+        else if (s.paramIndex == AMP) (s.devIdx == 0 ? amp1 : amp2).push_back({s.t_ns, s.value});
+    }
+    FrameAligner aligner;
+    aligner.align(amp1, amp2, freq, out);
+}
@@ -0,0 +1,65 @@
+#ifndef RECORDINGVIEW_H
+#define RECORDINGVIEW_H
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <cstddef>
+#include "recordingformat.h"
+#include "samplerecord.h"
+
+// Read-only view of a recording file (see recordingformat.h). The file is
+// memory-mapped and nothing is parsed or copied: samples() points straight
+// into the mapping. Opening only validates the header and finds the end of
+// the intact samples, looking backwards from the end of the file, so the
+// cost does not depend on the recording length.
+class RecordingView {
+public:
+    RecordingView() = default;
+    explicit RecordingView(const QString &path) { open(path); }
+    ~RecordingView() { close(); }
+
+    RecordingView(const RecordingView &) = delete;
+    RecordingView &operator=(const RecordingView &) = delete;
+
+    bool open(const QString &path);
+    void close();
+
+    bool isOpen() const { return m_header != nullptr; }
+    QString errorString() const { return m_error; }
+
+    const RecordingHeader &header() const { return *m_header; }
+
+    // All readings in acquisition order; FREQ comes from the generator,
+    // AMP and DIST from the sensors, each reading in its own sample
+    const RecordedSample *samples() const { return m_samples; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const RecordedSample *begin() const { return m_samples; }
+    const RecordedSample *end() const { return m_samples + m_size; }
+    const RecordedSample &operator[](std::size_t i) const { return m_samples[i]; }
+
+    // Bytes after the last intact sample (a write torn by a crash)
+    qint64 truncatedBytes() const { return m_truncated; }
+
+    // Duration covered by the samples
+    std::int64_t durationNs() const { return m_size ? m_samples[m_size - 1].t_ns - m_samples[0].t_ns : 0; }
+
+    // The time-aligned frequency / amplitude frames, built as
+    // ModbusReader::collectSamples() builds them live
+    void alignFrames(FrameStore &out) const;
+
+private:
+    QFile m_file;
+    uchar *m_map = nullptr;
+    const RecordingHeader *m_header = nullptr;
+    const RecordedSample *m_samples = nullptr;
+    std::size_t m_size = 0;
+    qint64 m_truncated = 0;
+    QString m_error;
+
+    bool fail(const QString &error);
+};
+
+#endif // RECORDINGVIEW_H
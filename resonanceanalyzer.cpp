@@ -0,0 +1,251 @@
+#include "resonanceanalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool halfPowerBandwidth(const std::vector<float> &freq,
+                        const std::vector<float> &amp,
+                        HalfPowerResult &result)
+{
+    result.ok = false;
+    if (freq.size() < 3 || amp.size() < 3) return false;
+
+    // Find peak
+    auto maxIt = std::max_element(amp.begin(), amp.end());
+    float peakAmp = *maxIt;
+    int idx = std::distance(amp.begin(), maxIt);
+    float peakFreq = freq[idx];
+    float threshold = peakAmp / std::sqrt(2.0);
+
+    float f1 = -1, f2 = -1;
+
+    // Lower crossing
+    for (int i = idx; i > 0; --i) {
+        if (amp[i] > threshold && amp[i - 1] <= threshold) {
+            float t = (threshold - amp[i]) / (amp[i - 1] - amp[i]);
+            f1 = freq[i] + t * (freq[i - 1] - freq[i]);
+            break;
+        }
+    }
+
+    // Upper crossing
+    for (int i = idx; i < (int)freq.size() - 1; ++i) {
+        if (amp[i] > threshold && amp[i + 1] <= threshold) {
+            float t = (threshold - amp[i]) / (amp[i + 1] - amp[i]);
+            f2 = freq[i] + t * (freq[i + 1] - freq[i]);
+            break;
+        }
+    }
+
+    result.peakFreq = peakFreq;
+    result.peakAmplitude = peakAmp;
+    result.threshold = threshold;
+    result.f1 = f1;
+    result.f2 = f2;
+    if (f1 < 0 || f2 < 0) return false;
+
+    result.deltaF = f2 - f1;
+    result.lossFactor = (f2 - f1) / peakFreq;
+    result.ok = true;
+    return true;
+}
+
+
+void RangeFilteredSeries::setRange(float fmin, float fmax)
+{
+    m_fmin = fmin;
+    m_fmax = fmax;
+    reset();
+}
+
+void RangeFilteredSeries::reset()
+{
+    ++m_epoch;
+    m_cursor = 0;
+    m_x.clear();
+    m_y.clear();
+}
+
+std::size_t RangeFilteredSeries::update(const FrameSnapshot &frames)
+{
+    if (!continues(frames)) {
+        reset();
+        m_generation = frames.generation();
+    }
+
+    std::size_t before = m_x.size();
+    frames.forEach(m_cursor, [this](const AlignedFrame &fr) {
+        if (fr.freq >= m_fmin && fr.freq <= m_fmax) {
+            m_x.push_back(fr.freq);
+            m_y.push_back(fr.ratio());
+        }
+    });
+    m_cursor = frames.size();
+    return m_x.size() - before;
+}
+
+
+void ResonanceAnalyzer::setFrequencyRange(float fmin, float fmax)
+{
+    m_fmin = fmin;
+    m_fmax = fmax;
+    m_series.setRange(fmin, fmax);
+    reset();
+}
+
+void ResonanceAnalyzer::reset()
+{
+    m_series.reset();
+    m_peakIdx = 0;
+    m_minY = 0;
+    m_upperCursor = 0;
+    m_hp = HalfPowerResult();
+    m_fit = LorentzianParams();
+    m_fitStats = FitStats();
+    m_fitSize = 0;
+    m_fitX.clear();
+    m_fitY.clear();
+}
+
+std::size_t ResonanceAnalyzer::update(const FrameSnapshot &frames)
+{
+    if (!m_series.continues(frames))
+        reset();
+
+    std::size_t before = m_series.size();
+    std::size_t added = m_series.update(frames);
+    if (!added) return 0;
+
+    const std::vector<float> &x = m_series.x();
+    const std::vector<float> &y = m_series.y();
+
+    bool peakMoved = before == 0;
+    if (before == 0) m_minY = y[0];
+    for (std::size_t i = before; i < y.size(); ++i) {
+        if (y[i] > y[m_peakIdx]) {
+            m_peakIdx = i;
+            peakMoved = true;
+        }
+        m_minY = std::min(m_minY, y[i]);
+    }
+
+    if (peakMoved) {
+        m_hp.peakFreq = x[m_peakIdx];
+        m_hp.peakAmplitude = y[m_peakIdx];
+        m_hp.threshold = m_hp.peakAmplitude / std::sqrt(2.0);
+        findLowerCrossing();
+        m_hp.f2 = -1;
+        m_upperCursor = m_peakIdx;
+    }
+    if (m_hp.f2 < 0)
+        scanUpperCrossing();
+
+    m_hp.ok = x.size() >= 3 && m_hp.f1 >= 0 && m_hp.f2 >= 0;
+    if (m_hp.ok) {
+        m_hp.deltaF = m_hp.f2 - m_hp.f1;
+        m_hp.lossFactor = m_hp.deltaF / m_hp.peakFreq;
+    }
+    return added;
+}
+
+void ResonanceAnalyzer::findLowerCrossing()
+{
+    const std::vector<float> &x = m_series.x();
+    const std::vector<float> &y = m_series.y();
+    const float thr = m_hp.threshold;
+    m_hp.f1 = -1;
+    for (std::size_t i = m_peakIdx; i > 0; --i) {
+        if (y[i] > thr && y[i - 1] <= thr) {
+            float t = (thr - y[i]) / (y[i - 1] - y[i]);
+            m_hp.f1 = x[i] + t * (x[i - 1] - x[i]);
+            return;
+        }
+    }
+}
+
+void ResonanceAnalyzer::scanUpperCrossing()
+{
+    const std::vector<float> &x = m_series.x();
+    const std::vector<float> &y = m_series.y();
+    const float thr = m_hp.threshold;
+    std::size_t i = m_upperCursor;
+    for (; i + 1 < y.size(); ++i) {
+        if (y[i] > thr && y[i + 1] <= thr) {
+            float t = (thr - y[i]) / (y[i + 1] - y[i]);
+            m_hp.f2 = x[i] + t * (x[i + 1] - x[i]);
+            break;
+        }
+    }
+    m_upperCursor = i;
+}
+
+bool ResonanceAnalyzer::fit(std::vector<float> &fitX, std::vector<float> &fitY)
+{
+    const std::vector<float> &x = m_series.x();
+    const std::vector<float> &y = m_series.y();
+    if (x.size() < 3) return false;
+
+    if (m_fit.valid && m_fitSize == x.size()) {
+        fitX = m_fitX;
+        fitY = m_fitY;
+        return true;
+    }
+
+    // Warm start from the previous fit unless it has left the data
+    LorentzianParams p = m_fit;
+    if (!p.valid || p.eta <= 0 || p.f0 < m_fmin || p.f0 > m_fmax) {
+        p = LorentzianParams();
+        p.A0 = y[m_peakIdx];
+        p.f0 = x[m_peakIdx];
+        p.eta = 0.05f;
+        p.alpha = 0.0f;
+        p.offset = m_minY;
+    }
+
+    // Fit curve (first pass)
+    FitStats first = fit_skewed_lorentzian_lm(x, y, p.A0, p.f0, p.eta, p.alpha, p.offset);
+
+    // Residual filtering
+    double pd[5] = {p.A0, p.f0, p.eta, p.alpha, p.offset};
+    std::vector<float> residuals(x.size());
+    lorentzian_eval(x.data(), y.data(), x.size(), pd, residuals.data());
+
+    float res_mean = mean(residuals);
+    float res_std  = stddev(residuals, res_mean);
+    float threshold = 2.0f * res_std;
+
+    std::vector<float> xf, yf;
+    xf.reserve(x.size());
+    yf.reserve(y.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        if (std::abs(residuals[i]) < threshold) {
+            xf.push_back(x[i]);
+            yf.push_back(y[i]);
+        }
+    }
+
+    // Refit on filtered data
+    FitStats second = xf.size() >= 5
+        ? fit_skewed_lorentzian_lm(xf, yf, p.A0, p.f0, p.eta, p.alpha, p.offset)
+        : first;
+
+    m_fitStats = second;
+    if (xf.size() >= 5) {
+        m_fitStats.iterations += first.iterations;
+        m_fitStats.evaluations += first.evaluations;
+    }
+
+    p.valid = true;
+    m_fit = p;
+    m_fitSize = x.size();
+
+    // Generate dense fitted curve
+    m_fitX = linspace(x.front(), x.back(), 150);
+    m_fitY.resize(m_fitX.size());
+    double pf[5] = {p.A0, p.f0, p.eta, p.alpha, p.offset};
+    lorentzian_eval(m_fitX.data(), nullptr, m_fitX.size(), pf, m_fitY.data());
+
+    fitX = m_fitX;
+    fitY = m_fitY;
+    return true;
+}
@@ -0,0 +1,110 @@
+#ifndef RESONANCEANALYZER_H
+#define RESONANCEANALYZER_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "samplerecord.h"
+#include "skewed_lorentzian_fit.hpp"
+
+// Half-power (-3 dB) bandwidth evaluation of a resonance curve
+struct HalfPowerResult {
+    bool ok = false;
+    float peakFreq = 0;
+    float peakAmplitude = 0;
+    float threshold = 0;
+    float f1 = -1, f2 = -1;
+    float deltaF = 0;
+    float lossFactor = 0;
+};
+
+// Skewed Lorentzian parameters, see skewed_lorentzian()
+struct LorentzianParams {
+    float A0 = 0, f0 = 0, eta = 0.05f, alpha = 0, offset = 0;
+    bool valid = false;
+};
+
+// Full evaluation over a sampled curve (used for the fitted curve).
+bool halfPowerBandwidth(const std::vector<float> &freq,
+                        const std::vector<float> &amp,
+                        HalfPowerResult &result);
+
+// In-range (frequency, amplitude ratio) points of a frame recording,
+// extended incrementally from a cursor into the snapshot.
+class RangeFilteredSeries {
+public:
+    void setRange(float fmin, float fmax);
+    void reset();
+
+    // Appends in-range frames recorded since the last call (starting over
+    // if the recording was cleared); returns the number of points added.
+    std::size_t update(const FrameSnapshot &frames);
+
+    bool continues(const FrameSnapshot &frames) const {
+        return frames.generation() == m_generation && frames.size() >= m_cursor;
+    }
+
+    const std::vector<float> &x() const { return m_x; }
+    const std::vector<float> &y() const { return m_y; }
+    std::size_t size() const { return m_x.size(); }
+
+    // Incremented by every reset(); consumers holding indices into x()/y()
+    // must start over when it changes.
+    std::uint64_t epoch() const { return m_epoch; }
+
+private:
+    float m_fmin = 0, m_fmax = 1000;
+    std::uint64_t m_epoch = 0;
+    std::size_t m_cursor = 0;          // next frame index to consume
+    std::uint64_t m_generation = 0;
+    std::vector<float> m_x, m_y;
+};
+
+// Incremental loss-factor analysis of a growing recording.
+// update() consumes only frames appended since the previous call: the
+// frequency-filtered ratio series, the running peak and the half-power
+// crossings are all extended in O(new samples) (plus, when the peak moves,
+// a walk back to the lower crossing, which is bounded by the band width).
+// fit() is warm-started from the previous fit parameters.
+class ResonanceAnalyzer {
+public:
+    void setFrequencyRange(float fmin, float fmax);
+    void reset();
+
+    // Returns the number of new in-range points.
+    std::size_t update(const FrameSnapshot &frames);
+
+    const std::vector<float> &x() const { return m_series.x(); }
+    const std::vector<float> &y() const { return m_series.y(); }
+
+    // Half-power result on the raw (filtered) data
+    const HalfPowerResult &halfPower() const { return m_hp; }
+
+    // Skewed Lorentzian fit of the filtered data with one outlier-rejection
+    // pass, sampled at 150 points. Cached until new points arrive.
+    bool fit(std::vector<float> &fitX, std::vector<float> &fitY);
+    const LorentzianParams &fitParams() const { return m_fit; }
+    // Solver counters of the most recent fit (both passes summed)
+    const FitStats &fitStats() const { return m_fitStats; }
+
+private:
+    float m_fmin = 0, m_fmax = 1000;
+
+    RangeFilteredSeries m_series;
+    std::size_t m_peakIdx = 0;
+    float m_minY = 0;
+    std::size_t m_upperCursor = 0;     // next index to test for the upper crossing
+    HalfPowerResult m_hp;
+
+    LorentzianParams m_fit;
+    FitStats m_fitStats;
+    std::size_t m_fitSize = 0;         // points the cached fit was made on
+    std::vector<float> m_fitX, m_fitY;
+
+    void findLowerCrossing();
+    void scanUpperCrossing();
+};
+
+#endif // RESONANCEANALYZER_H
@@ -0,0 +1,92 @@
+#ifndef SAMPLERECORD_H
+#define SAMPLERECORD_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "appendonlystore.h"
+
+// Quantities read from the devices
+enum params_list { AMP, FREQ, DIST };
+
+// One reading of one quantity, stamped with the acquisition clock
+// (monotonic, nanoseconds since the reader was created).
+struct SampleRecord {
+    std::int64_t t_ns;
+    float value;
+};
+
+// Sensor readings aligned in time: both amplitudes and the generator
+// frequency as they were at t_ns (the sensor 1 reading time).
+struct AlignedFrame {
+    std::int64_t t_ns;
+    float freq;
+    float amp1;
+    float amp2;
+
+    // Transmissibility as plotted and analysed
+    float ratio() const { return amp2 != 0 ? amp1 / amp2 : 0.0f; }
+};
+
+// Linear interpolation of a time-ordered record series at t. cursor is a
+// forward-only hint so a monotonic sequence of queries costs O(1) amortized.
+inline float interpolateAt(const std::vector<SampleRecord> &r, std::size_t &cursor, std::int64_t t)
+{
+    while (cursor + 1 < r.size() && r[cursor + 1].t_ns <= t) ++cursor;
+    if (cursor + 1 >= r.size()) return r[cursor].value;
+
+    const SampleRecord &a = r[cursor];
+    const SampleRecord &b = r[cursor + 1];
+    if (t <= a.t_ns || b.t_ns == a.t_ns) return a.value;
+    double w = double(t - a.t_ns) / double(b.t_ns - a.t_ns);
+    return a.value + float(w) * (b.value - a.value);
+}
+
+// Builds AlignedFrames incrementally: each sensor 1 amplitude reading becomes
+// a frame once the frequency and sensor 2 series have readings at or after
+// its timestamp, so values are interpolated rather than paired by index.
+class FrameAligner {
+public:
+    void reset() { m_ampCursor = m_freqCursor = m_amp2Cursor = 0; }
+
+    // Appends the frames that became alignable to out (anything with
+    // push_back(AlignedFrame)); returns how many were added.
+    template <typename Out>
+    std::size_t align(const std::vector<SampleRecord> &amp1,
+                      const std::vector<SampleRecord> &amp2,
+                      const std::vector<SampleRecord> &freq,
+                      Out &out)
+    {
+        std::size_t added = 0;
+        if (freq.empty() || amp2.empty()) return added;
+
+        while (m_ampCursor < amp1.size()) {
+            const SampleRecord &a = amp1[m_ampCursor];
+            // not bracketed yet: wait for later frequency / sensor 2 readings
+            if (a.t_ns > freq.back().t_ns || a.t_ns > amp2.back().t_ns) break;
+
+            // before the first reading of the other series: nothing to interpolate from
+            if (a.t_ns >= freq.front().t_ns && a.t_ns >= amp2.front().t_ns) {
+                out.push_back({a.t_ns,
+                               interpolateAt(freq, m_freqCursor, a.t_ns),
+                               a.value,
+                               interpolateAt(amp2, m_amp2Cursor, a.t_ns)});
+                ++added;
+            }
+            ++m_ampCursor;
+        }
+        return added;
+    }
+
+private:
+    std::size_t m_ampCursor = 0;
+    std::size_t m_freqCursor = 0;
+    std::size_t m_amp2Cursor = 0;
+};
+
+using FrameStore = AppendOnlyStore<AlignedFrame>;
+using FrameSnapshot = FrameStore::Snapshot;
+
+#endif // SAMPLERECORD_H
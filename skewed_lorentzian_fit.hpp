@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <numeric>
 #include <iostream>
+#include "lorentzian_kernels.h"
 
 // ---------- Utilities ----------
 inline std::vector<float> linspace(float start, float end, size_t num) {
@@ -30,19 +31,15 @@ inline float stddev(const std::vector<float>& v, float vmean=-1.0) {
 // ---------- Model ----------
 inline float skewed_lorentzian(float f, float A0, float f0, float eta, float alpha, float offset) {
     float df_norm = (f - f0) / f0;
-    float denom = 1.0 + (df_norm * df_norm) / (eta * eta);
-    return A0 / denom * (1.0 + alpha * df_norm) + offset;
+    float denom = 1.0f + (df_norm * df_norm) / (eta * eta);
+    return A0 / denom * (1.0f + alpha * df_norm) + offset;
 }
 
 // ---------- SSE ----------
 inline float sse(const std::vector<float>& x, const std::vector<float>& y,
                   float A0, float f0, float eta, float alpha, float offset) {
-    float sum = 0.0;
-    for (size_t i = 0; i < x.size(); ++i) {
-        float d = skewed_lorentzian(x[i], A0, f0, eta, alpha, offset) - y[i];
-        sum += d * d;
-    }
-    return sum;
+    const double p[5] = {A0, f0, eta, alpha, offset};
+    return float(lorentzian_sse(x.data(), y.data(), std::min(x.size(), y.size()), p));
 }
 
 // ---------- Simple coordinate-search optimizer (very small-data friendly) ----------
@@ -87,3 +84,113 @@ inline void fit_skewed_lorentzian_basic(const std::vector<float>& x, const std::
         }
     }
 }
+
+// ---------- Levenberg-Marquardt fit with analytic Jacobian ----------
+struct FitStats {
+    int iterations = 0;   // accepted + rejected LM steps
+    int evaluations = 0;  // passes over the data (residuals or Jacobian)
+    double sse = 0.0;     // final sum of squared residuals
+    bool converged = false;
+};
+
+// Solve the 5x5 system A x = b in place (Gaussian elimination, partial pivoting).
+inline bool solve5(double A[5][5], double b[5], double x[5]) {
+    for (int c = 0; c < 5; ++c) {
+        int piv = c;
+        for (int r = c + 1; r < 5; ++r)
+            if (std::abs(A[r][c]) > std::abs(A[piv][c])) piv = r;
+        if (std::abs(A[piv][c]) < 1e-300) return false;
+        if (piv != c) {
+            for (int k = 0; k < 5; ++k) std::swap(A[c][k], A[piv][k]);
+            std::swap(b[c], b[piv]);
+        }
+        for (int r = c + 1; r < 5; ++r) {
+            const double m = A[r][c] / A[c][c];
+            for (int k = c; k < 5; ++k) A[r][k] -= m * A[c][k];
+            b[r] -= m * b[c];
+        }
+    }
+    for (int r = 4; r >= 0; --r) {
+        double s = b[r];
+        for (int k = r + 1; k < 5; ++k) s -= A[r][k] * x[k];
+        x[r] = s / A[r][r];
+    }
+    return true;
+}
+
+// Marquardt-scaled damping; stops when the relative SSE decrease or the
+// relative step falls below tol, or after max_iters steps.
+inline FitStats fit_skewed_lorentzian_lm(const std::vector<float>& x, const std::vector<float>& y,
+                                         float &A0, float &f0, float &eta, float &alpha, float &offset,
+                                         int max_iters = 100, double tol = 1e-10) {
+    FitStats st;
+    double p[5] = {A0, f0, eta, alpha, offset};
+    const size_t n = std::min(x.size(), y.size());
+    if (n < 5 || f0 <= 0.0f || eta == 0.0f) return st;
+    if (p[2] < 0) p[2] = -p[2];
+
+    double lambda = 1e-3;
+    double err = lorentzian_sse(x.data(), y.data(), n, p);
+    ++st.evaluations;
+
+    double JTJ[5][5], JTr[5];
+    bool needJacobian = true;
+
+    while (st.iterations < max_iters) {
+        if (needJacobian) {
+            lorentzian_normal_equations(x.data(), y.data(), n, p, JTJ, JTr);
+            ++st.evaluations;
+            needJacobian = false;
+        }
+        ++st.iterations;
+
+        double A[5][5], rhs[5], delta[5];
+        for (int a = 0; a < 5; ++a) {
+            for (int b = 0; b < 5; ++b) A[a][b] = JTJ[a][b];
+            A[a][a] += lambda * std::max(JTJ[a][a], 1e-12);
+            rhs[a] = JTr[a];
+        }
+        if (!solve5(A, rhs, delta)) { lambda *= 10.0; continue; }
+
+        double trial[5];
+        double stepNorm = 0.0, paramNorm = 0.0;
+        for (int a = 0; a < 5; ++a) {
+            trial[a] = p[a] + delta[a];
+            stepNorm += delta[a] * delta[a];
+            paramNorm += p[a] * p[a];
+        }
+
+        // keep physical constraints: eta > 0, f0 > 0
+        if (trial[1] <= 0.0 || trial[2] <= 0.0) {
+            lambda *= 10.0;
+            if (lambda > 1e12) break;
+            continue;
+        }
+
+        const double trialErr = lorentzian_sse(x.data(), y.data(), n, trial);
+        ++st.evaluations;
+
+        if (trialErr < err) {
+            const double drop = (err - trialErr) / std::max(err, 1e-300);
+            std::copy(trial, trial + 5, p);
+            err = trialErr;
+            lambda = std::max(lambda * 0.1, 1e-12);
+            needJacobian = true;
+            if (drop < tol || std::sqrt(stepNorm) < tol * (std::sqrt(paramNorm) + tol)) {
+                st.converged = true;
+                break;
+            }
+        } else {
+            lambda *= 10.0;
+            if (lambda > 1e12) {
+                // no descent direction left: at a (local) minimum
+                st.converged = true;
+                break;
+            }
+        }
+    }
+
+    A0 = p[0]; f0 = p[1]; eta = p[2]; alpha = p[3]; offset = p[4];
+    st.sse = err;
+    return st;
+}
@@ -0,0 +1,75 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// One thread may call push(), one (other) thread may call pop()/drain().
+// Capacity must be a power of two; one slot is never used.
+template <typename T, std::size_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and counts a drop) when the buffer is full.
+    bool push(const T &item) {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t next = (head + 1) & (Capacity - 1);
+        if (next == m_tail.load(std::memory_order_acquire)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[head] = item;
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool pop(T &item) {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+        item = m_items[tail];
+        m_tail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: hand every pending item to fn, returns the number consumed.
+    template <typename Fn>
+    std::size_t drain(Fn &&fn) {
+        std::size_t n = 0;
+        T item;
+        while (pop(item)) {
+            fn(item);
+            ++n;
+        }
+        return n;
+    }
+
+    bool empty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    // Items pushed and not consumed yet. On the producer side capacity() - size()
+    // is room that is guaranteed to be there.
+    std::size_t size() const {
+        return (m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire)) &
+               (Capacity - 1);
+    }
+
+    std::size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static constexpr std::size_t capacity() { return Capacity - 1; }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<std::size_t> m_head{0};   // written by producer
+    alignas(64) std::atomic<std::size_t> m_tail{0};   // written by consumer
+    alignas(64) std::atomic<std::size_t> m_dropped{0};
+};
+
+#endif // SPSCRINGBUFFER_H
@@ -0,0 +1,52 @@
+#include "sweepanalysis.h"
+#include <QElapsedTimer>
+#include <utility>
+#include "recordingview.h"
+
+SweepAnalysis analyzeRecording(const QString &path, const SweepAnalysisOptions &options) {
+    QElapsedTimer timer;
+    timer.start();
+
+    SweepAnalysis result;
+    result.path = path;
+
+    FrameStore frames;
+    {
+        RecordingView view(path);
+        if (!view.isOpen()) {
+            result.error = view.errorString();
+            return result;
+        }
+        result.readings = view.size();
+        result.fmin = options.fmin > 0 ? options.fmin : view.header().startFreq;
+        result.fmax = options.fmax > 0 ? options.fmax : view.header().endFreq;
+        view.alignFrames(frames);
+    }
+    if (result.fmin > result.fmax) std::swap(result.fmin, result.fmax);
+
+    const FrameSnapshot snapshot = frames.snapshot();
+    result.frames = snapshot.size();
+
+    ResonanceAnalyzer analyzer;
+    analyzer.setFrequencyRange(result.fmin, result.fmax);
+    result.points = analyzer.update(snapshot);
+    if (result.points < 3) {
+        result.error = "Too few points in range";
+        result.durationMs = timer.nsecsElapsed() / 1e6;
+        return result;
+    }
+
+    result.hp = analyzer.halfPower();
+    if (options.fit) {
+        std::vector<float> fitX, fitY;
+        if (analyzer.fit(fitX, fitY)) {
+            result.fitted = true;
+            halfPowerBandwidth(fitX, fitY, result.fitHp);
+            result.fitParams = analyzer.fitParams();
+        }
+        result.fitStats = analyzer.fitStats();
+    }
+
+    result.durationMs = timer.nsecsElapsed() / 1e6;
+    return result;
+}
@@ -0,0 +1,41 @@
+#ifndef SWEEPANALYSIS_H
+#define SWEEPANALYSIS_H
+
+#pragma once
+
+#include <QString>
+#include <cstddef>
+#include "resonanceanalyzer.h"
+
+struct SweepAnalysisOptions {
+    // Frequency range analysed; a bound <= 0 takes the sweep's own from the
+    // recording header
+    float fmin = 0, fmax = 0;
+    bool fit = true;            // skewed Lorentzian fit, as with "Approximation" checked
+};
+
+// Outcome of the analysis of one recorded sweep
+struct SweepAnalysis {
+    QString path;
+    QString error;              // empty on success
+    std::size_t readings = 0;   // samples in the recording
+    std::size_t frames = 0;     // aligned frames
+    std::size_t points = 0;     // frames in the frequency range
+    float fmin = 0, fmax = 0;
+
+    HalfPowerResult hp;         // raw data
+    bool fitted = false;
+    HalfPowerResult fitHp;      // fitted curve, what the GUI shows with a fit
+    LorentzianParams fitParams;
+    FitStats fitStats;
+    double durationMs = 0;
+
+    bool ok() const { return error.isEmpty(); }
+};
+
+// Runs the analysis the GUI runs on a live sweep (ResonanceAnalyzer, then
+// the half-power evaluation of the raw data and of the fitted curve) on a
+// recording. Needs no event loop; safe to call on several threads at once.
+SweepAnalysis analyzeRecording(const QString &path, const SweepAnalysisOptions &options);
+
+#endif // SWEEPANALYSIS_H
@@ -0,0 +1,202 @@
+#include "sweeprecorder.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Plain file descriptors: QFile has no way to force data to the disk
+namespace {
+
+int createFile(const QString &path) {
+#ifdef Q_OS_WIN
+    return _wopen(reinterpret_cast<const wchar_t *>(path.utf16()),
+                  _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+bool writeAll(int fd, const void *data, std::size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+#ifdef Q_OS_WIN
+        int n = _write(fd, p, unsigned(std::min<std::size_t>(size, 1u << 30)));
+#else
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) return false;
+        p += n;
+        size -= std::size_t(n);
+    }
+    return true;
+}
+
+bool syncFile(int fd) {
+#ifdef Q_OS_WIN
+    return _commit(fd) == 0;
+#elif defined(Q_OS_LINUX)
+    return ::fdatasync(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+void closeFd(int fd) {
+#ifdef Q_OS_WIN
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+// A new file survives a power loss only once its directory entry does
+void syncDirectoryOf(const QString &path) {
+#ifndef Q_OS_WIN
+    int fd = ::open(QFile::encodeName(QFileInfo(path).absolutePath()).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+} // namespace
+
+SweepRecorder::SweepRecorder(QObject *parent) : QObject(parent) {
+    m_syncTimer = new QTimer(this);
+    m_syncTimer->setInterval(SyncIntervalMs);
+    connect(m_syncTimer, &QTimer::timeout, this, &SweepRecorder::flush);
+}
+
+SweepRecorder::~SweepRecorder() {
+    m_accepting = 0;
+    closeFile();
+}
+
+void SweepRecorder::open(const QString &path, const RecordingHeader &header) {
+    const std::uint32_t recording = m_lastRecording.fetch_add(1) + 1;
+    m_accepting = recording;
+    QMetaObject::invokeMethod(this, [=]() { openFile(path, header, recording); }, Qt::QueuedConnection);
+}
+
+void SweepRecorder::close() {
+    m_accepting = 0;
+    QMetaObject::invokeMethod(this, [this]() { closeFile(); }, Qt::QueuedConnection);
+}
+
+void SweepRecorder::openFile(const QString &path, const RecordingHeader &header, std::uint32_t recording) {
+    closeFile();
+
+    m_fileRecording = recording;
+    m_path = path;
+    m_written = 0;
+    m_fd = createFile(path);
+    if (m_fd < 0) {
+        fail("create");
+        return;
+    }
+
+    RecordingHeader h = header;
+    std::memcpy(h.magic, RecordingHeader::Magic, sizeof(h.magic));
+    std::memset(h.reserved, 0, sizeof(h.reserved));
+    h.version = RecordingHeader::CurrentVersion;
+    h.headerSize = sizeof(RecordingHeader);
+    h.sampleSize = sizeof(RecordedSample);
+    if (!writeAll(m_fd, &h, sizeof(h)) || !syncFile(m_fd)) {
+        fail("write");
+        return;
+    }
+    syncDirectoryOf(path);
+
+    // Readings that came in before the file was open go first; those of an
+    // even newer recording wait for its own openFile()
+    m_batch.clear();
+    std::vector<QueuedSample> later;
+    for (const QueuedSample &q : m_early) {
+        if (q.recording == recording) m_batch.push_back(q.sample);
+        else if (q.recording > recording) later.push_back(q);
+    }
+    m_early.swap(later);
+    flush();
+    if (m_fd >= 0)
+        m_syncTimer->start();
+}
+
+void SweepRecorder::closeFile() {
+    if (m_fd < 0) return;
+    m_syncTimer->stop();
+    flush();
+    if (m_fd >= 0) {
+        closeFd(m_fd);
+        m_fd = -1;
+    }
+}
+
+// Sorts the queued readings: the open file's go to m_batch, those of a
+// recording still to be opened to m_early, those of a closed or failed one
+// are dropped
+void SweepRecorder::takeQueued() {
+    m_queue.drain([this](const QueuedSample &q) {
+        if (q.recording == m_fileRecording) {
+            if (m_fd >= 0) m_batch.push_back(q.sample);
+        } else if (q.recording > m_fileRecording) {
+            m_early.push_back(q);
+        }
+    });
+
+    const std::size_t dropped = m_queue.dropped();
+    m_droppedMetric.add(dropped - m_droppedReported);
+    m_droppedReported = dropped;
+}
+
+// Writes m_batch (after what is queued for the open file) and syncs
+void SweepRecorder::flush() {
+    takeQueued();
+    if (m_fd < 0 || m_batch.empty()) {
+        m_batch.clear();
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_batch.size(); ++i) {
+        m_batch[i].marker = RecordedSample::Marker;
+        m_batch[i].sequence = std::uint8_t(m_written + i);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!writeAll(m_fd, m_batch.data(), m_batch.size() * sizeof(RecordedSample)) || !syncFile(m_fd)) {
+        fail("write");
+        return;
+    }
+    m_flushMetric.record(timer.nsecsElapsed());
+    m_written += m_batch.size();
+    m_writtenMetric.add(m_batch.size());
+    m_batch.clear();
+}
+
+// Recording stops at the first I/O error; acquisition goes on without it
+void SweepRecorder::fail(const QString &what) {
+    emit errorOccurred(QString("Recording %1 failed (%2): %3").arg(m_path, what, std::strerror(errno)));
+    // Unless a newer recording has been opened meanwhile
+    std::uint32_t current = m_fileRecording;
+    m_accepting.compare_exchange_strong(current, 0);
+    m_syncTimer->stop();
+    closeFd(m_fd);
+    m_fd = -1;
+    // Nothing of this recording is carried into the next one
+    m_batch.clear();
+    takeQueued();
+}
@@ -0,0 +1,82 @@
+#ifndef SWEEPRECORDER_H
+#define SWEEPRECORDER_H
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <vector>
+#include "recordingformat.h"
+#include "spscringbuffer.h"
+#include "metrics.h"
+
+// Streams the readings of a sweep into a recording file (see
+// recordingformat.h) on its own thread. The acquisition thread only pushes
+// each reading into a lock-free queue; every SyncIntervalMs the recorder
+// thread writes what arrived in one call and syncs the file to disk, so a
+// crash or power loss loses at most the readings of that interval.
+class SweepRecorder : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int SyncIntervalMs = 250;
+
+    explicit SweepRecorder(QObject *parent = nullptr);
+    ~SweepRecorder();
+
+    // Any thread. Readings appended from now on go to a new file at path;
+    // a file still open is finished first.
+    void open(const QString &path, const RecordingHeader &header);
+    // Any thread. Writes the remaining readings and closes the file.
+    void close();
+
+    // Single producer (the acquisition thread): no I/O, no locks, no
+    // allocation. Ignored while no recording is open.
+    void append(std::int64_t t_ns, int devIdx, int paramIndex, float value) {
+        const std::uint32_t recording = m_accepting.load(std::memory_order_relaxed);
+        if (!recording) return;
+        m_queue.push({{t_ns, value, std::uint8_t(devIdx), std::uint8_t(paramIndex), 0, 0}, recording});
+    }
+
+    // Readings lost because the queue was full
+    std::size_t dropped() const { return m_queue.dropped(); }
+
+signals:
+    void errorOccurred(const QString &error);
+
+private:
+    // Readings carry the id of the recording they were appended to, so none
+    // ends up in another recording's file whatever the order in which the
+    // queued openFile()/closeFile() calls and the readings arrive
+    struct QueuedSample {
+        RecordedSample sample;
+        std::uint32_t recording;
+    };
+
+    std::atomic<std::uint32_t> m_accepting{0};   // recording readings go to, 0 = none
+    std::atomic<std::uint32_t> m_lastRecording{0};
+    SpscRingBuffer<QueuedSample, 8192> m_queue;
+
+    // recorder thread only
+    QTimer *m_syncTimer;
+    int m_fd = -1;
+    std::uint32_t m_fileRecording = 0;   // recording of m_path
+    QString m_path;
+    std::size_t m_written = 0;
+    std::vector<RecordedSample> m_batch;
+    std::vector<QueuedSample> m_early;   // of a recording whose file is not open yet
+    std::size_t m_droppedReported = 0;
+    Histogram &m_flushMetric = Metrics::instance().histogram("recorder.flush");
+    Counter &m_writtenMetric = Metrics::instance().counter("recorder.samples");
+    Counter &m_droppedMetric = Metrics::instance().counter("recorder.dropped");
+
+    void openFile(const QString &path, const RecordingHeader &header, std::uint32_t recording);
+    void closeFile();
+    void takeQueued();
+    void flush();
+    void fail(const QString &what);
+};
+
+#endif // SWEEPRECORDER_H